@@ -92,9 +92,9 @@ fi
 if [ $LINK_ONLY -eq 0 ]; then
 
     if [ $DEBUGMODE -eq 1 ]; then
-        DEBUG_INFO="-ggdb -g -fsanitize=address -Wshadow-compatible-local"
+        DEBUG_INFO="-ggdb -g -fsanitize=address -Wshadow-compatible-local -DNODEPOOL_DEBUG"
     else
-        DEBUG_INFO="-s"
+        DEBUG_INFO="-s -O2"
     fi
 
 	if [ $REBUILD_APPLICATION -eq 1 ]; then
@@ -0,0 +1,30 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include "parameters.h"
+#include "operators.h"
+
+#include <string>
+
+/*  Benchmarks
+     Run with:  test.elf --bench <name> [csv file]
+     Each benchmark uses the loaded config.json parameters and point cloud data.
+*/
+
+namespace Benchmark {
+
+    bool run(const std::string& name, Parameters* params, const Operators::EqPoints& data); // returns false for an unknown benchmark
+
+    void threads(Parameters* params, const Operators::EqPoints& data); // repopulation throughput from 1 to 64 worker threads
+    void arena(Parameters* params, const Operators::EqPoints& data); // repopulation with per-node frees vs arena resets of the dead individuals
+    void trees(Parameters* params, const Operators::EqPoints& data); // copy and crossover throughput of pool node trees vs flat trees
+    void traversal(Parameters* params, const Operators::EqPoints& data); // per-call node lists vs scratch buffer collection and cursor walks
+    void dispatch(Parameters* params, const Operators::EqPoints& data); // cost of one threaded phase - fresh threads vs the persistent worker pool
+    void selection(Parameters* params, const Operators::EqPoints& data); // three full sorts of the population vs partial selection on rank keys
+    void duplicates(Parameters* params, const Operators::EqPoints& data); // duplicate detection by pairwise form comparison vs a set of form hashes
+    void kernels(Parameters* params, const Operators::EqPoints& data); // every batch operator kernel at each supported instruction set vs the scalar loop
+    void jit(Parameters* params, const Operators::EqPoints& data); // Program interpreter vs a minimal native x86-64 loop per tree (the measurement behind declining the JIT)
+
+}
+
+#endif // __BENCHMARK_H__
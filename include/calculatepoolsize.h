@@ -3,7 +3,7 @@
 
 #include <cstddef>
 
-extern size_t calculatePoolSize(); // returns the number of bytes that a single rootnode allocates
+extern size_t calculatePoolSize(); // returns the number of bytes that a single new rootnode allocates (object and first sub-pool)
 
 
 
@@ -0,0 +1,66 @@
+#ifndef __COMPACT_POPULATION_H__
+#define __COMPACT_POPULATION_H__
+
+#include "forward.h"
+#include "operators.h"
+#include "nodetypes.h"
+
+#include <vector>
+#include <stdint.h>
+
+/*  CompactPopulation: a whole population as variable-length byte encodings in one buffer
+
+     A RootNode costs its node pool, form string and result table even while nobody works on it.
+     The compact population keeps every individual as its preorder byte encoding instead and only
+     turns it back into nodes (in a scratch root of the worker) while it is mutated or scored.
+     The name of a node takes the low nibble of its first byte, the high nibble holds a short payload:
+        operator             [name]                        (the arity follows from the operator)
+        variable 0..14       [name | (index + 1) << 4]
+        variable >= 15       [name] varint(index)
+        constant k / scale   [name | 1 << 4] varint(zigzag(k))  (every constant rounded to decimalPlaces)
+        other constants      [name] 8 raw bytes
+     add(var0, mul(2.5, var1)) takes 7 bytes:  [add] [var0] [mul] [const] 0xF4 0x03 [var1]   (2.5 = 250 / 100)
+
+     Building a generation never touches the current buffer: every worker encodes its individuals
+     into its own chunk, commit() joins the chunks into the next buffer and swaps it in. The old
+     buffer is kept for the generation after that, so a steady population allocates nothing.
+*/
+
+class CompactPopulation {
+public:
+    struct Individual {
+        uint64_t offset;   // first byte of the encoding - within the chunk of the writer until commit()
+        uint32_t size;     // bytes of the encoding
+        uint16_t chunk;    // writer that encoded the individual
+        bool rejected;     // score is only a lower bound
+        float score, complexity;
+    };
+
+    std::vector<Individual> individuals; // the current generation - sorted in place
+
+    CompactPopulation(VTYPE scale=100); // scale: constants that are a whole multiple of 1 / scale take the short form
+
+    void begin(size_t count, size_t writers); // start the next generation of count individuals written by at most writers threads
+    Individual& write(size_t writer, size_t index, const Node* root); // encode the next generation's individual index - thread safe for different writers and indices
+    void commit(); // the next generation becomes the current one
+
+    Node* decode(size_t index, RootNode& root) const; // rebuild an individual of the current generation as the tree of root (thread safe)
+
+    inline size_t size() const { return individuals.size(); }
+    inline size_t bytes() const { return buffer.size(); } // encoded bytes of the current generation
+    size_t memoryUsage() const; // heap bytes of the buffers, chunks and individual records
+
+    static void encode(const Node* root, std::vector<uint8_t>& out, VTYPE scale);
+    static Node* decode(const uint8_t*& data, RootNode& root, VTYPE scale); // one subtree - advances data past it
+
+private:
+    VTYPE scale;
+    std::vector<uint8_t> buffer, spare; // current generation and the buffer of the one before
+    std::vector<std::vector<uint8_t>> chunks; // one per writer
+    std::vector<Individual> next;
+};
+
+static_assert(sizeof(CompactPopulation::Individual) == 24, "an individual record is three 8-byte words");
+
+
+#endif // __COMPACT_POPULATION_H__
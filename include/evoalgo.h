@@ -12,6 +12,15 @@
 #include "node.h"
 #include "calculatepoolsize.h"
 #include "stringparser.h"
+#include "subtreecache.h"
+#include "racing.h"
+#include "interval.h"
+#include "memoryreport.h"
+#include "numa.h"
+#include "compactpopulation.h"
+#include "threadpool.h"
+#include "flattree.h"
+#include "formset.h"
 
 #include <numeric>
 #include <variant>
@@ -30,9 +39,36 @@ public:
     Population shadowPopulation; // allocated space for temporary rootnode modification/calculations
 
     const Operators::EqPoints& data;
+    Operators::BasicEqPoints<float> floatData; // single precision copy of the data (only with float scoringPrecision)
     int generation, drawGraphCount;
+    size_t threadCount; // number of worker threads used by threadGenerator
+    ThreadPool workers; // persistent worker threads of threadGenerator - grows to the largest threadCount
+    std::vector<double> taskCosts; // estimated cost of every index of the current threaded task
 
     std::vector<float> scoreDatabase; // previous scores
+    float scoreCutoff; // RMS score of the survival cutoff in the previous generation - bound for early-abort scoring
+    static constexpr float FLOAT_SCORE_MARGIN = 1e-3f; // relative difference allowed between a float score and its double score - float scores are lowered by it to bound the double score
+    size_t fitnessMemory; // peak of the fitness runs in the last memory report - the subtree cache budget leaves room for it
+    SubtreeCache subtreeCache; // subtree results shared by the population - reset every generation
+    Racing racing; // progressive sampling of the population scores - reshuffled every generation
+    IntervalScreen intervalScreen; // interval bounds of new trees over the data - skips trees that are NaN or constant everywhere
+    CompactPopulation compact; // the population with useCompactPopulation - population and shadowPopulation stay empty
+    Population scratch; // trees of the compact population being worked on - 3 per worker: both parents and the individual
+    std::vector<FlatTree> survivorTrees; // snapshot of the survivors the pipelined children are bred from
+    std::vector<uint64_t> selectionKeys; // rank keys of sortPopulation - kept between generations
+    Population ranked; // sortPopulation gathers the new order here and swaps it in
+    FormSet formSet; // form hashes of the population while repopulate removes duplicates
+    std::vector<uint8_t> formPending; // children whose form is not in formSet yet
+
+    struct TrimRequest { // workTrimPools argument
+        double watermark;
+        std::atomic<size_t> released; // bytes
+    };
+
+    struct DuplicateRequest { // workRemoveDuplicates argument
+        uint32_t cutoff; // roots below are survivors - their forms are only added
+        std::atomic<size_t> duplicates; // children re-mutated in this round
+    };
 
     EvoAlgo(const Parameters* params=Parameters::Params(), const Operators::EqPoints& data=Parameters::Params()->points);
     virtual ~EvoAlgo();
@@ -40,19 +76,43 @@ public:
     static void workRootNodeAllocator(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
     static void workSimplifyScoreComplexity(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
     static void workScore(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workCacheSubtrees(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workStoreResults(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workRace(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
     static void workFitness(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workTrimPools(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
     static void workRepopulate(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workRemoveDuplicates(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workPipeline(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workCompactAllocator(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workCompactGeneration(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workSettleScore(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
+    static void workCompactSettleScore(EvoAlgo* _this, size_t i, size_t popSize, size_t spread, void* extra);
     void threadGenerator(size_t start, size_t stop, Worker worker, void* extra=nullptr);
+    double taskCost(Worker worker, size_t i) const; // relative work of a worker on one root - node count, times the fitness evaluations for fitness runs
 
 
     void mutate(RootNode& rt, int iters);
-    void sortPopulation();
+    void sortPopulation(size_t top=SIZE_MAX, size_t worst=0, bool bounds=false); // the top roots in order - the worst roots at the end, the rest in between unordered
+    void sortCompact(size_t top=SIZE_MAX, bool bounds=false); // bounds: rejected lower bounds rank with the complete scores instead of after them
+    size_t settleRejected(size_t top, float* minScore=nullptr); // score the rejected roots in full until the top is exact - parsimony scores with minScore, RMS without
+    float parsimonyScore(float rms, float complexity, float minScore) const;
+    size_t selectionSize(size_t count) const; // ranks a generation needs in order - the survivors, the parsimony pivot and the drawn best
     void repopulate();
     bool iteration();
+    bool pipelineIteration(); // every individual goes through a whole generation on its own - selection is the only barrier
+    bool compactIteration(); // a whole generation of the compact population in one pass
+    void select(); // sort, parsimony scores and sort again
+    bool finishGeneration(RootNode& best, const Clock& genTimer); // score history, drawing and output of the best tree - returns true once accurate enough
 
     void drawGraph(RootNode& rt);
 
     bool checkForMemoryConsistency();
+    MemoryReport memoryReport(); // bytes owned by the engine - the caches and fitness runs at their peak since the last report
+    MemoryReport residentMemory() const; // the part of the memory report that lives through the whole generation - no cache results or fitness runs
+    size_t cacheBudget(size_t configured, size_t others) const; // bytes a cache may use - its own budget, capped at what memoryBudget leaves after the resident memory and the other cache
+    size_t incrementalBudget() const; // cacheBudget of the incremental node results
+    size_t trimPools(double watermark); // trim every node pool on the worker threads - returns the released bytes
 
     void run();
 };
@@ -3,49 +3,89 @@
 
 class RootNode;
 class NodePool;
-struct uNode;
-
-#ifdef REQUIRE_NODEPOOL
-#include "nodepool.h"
-#endif
+union uNode;
 
 #include "node.h"
 #include "nodetypes.h"
 #include "parameters.h"
 #include "stringparser.h"
+#include "noderesults.h"
 
 #include <variant>
 #include <list>
+#include <vector>
 #include <array>
 #include <mutex>
 #include <atomic>
 
+/*  NodePool arena
+     Slots are handed out like an arena: freed slots first, otherwise the next untouched slot of the
+     current sub-pool. reset() rewinds the arena and drops the free list, which gives back every node
+     of the pool at once without walking the tree - a dead individual is cleared in O(1) and its child is
+     built into the same warm sub-pools.
+     Sub-pools behind the arena cursor were never touched since the last reset, so trim() can release
+     them between generations. A bloated tree that shrank again still has its nodes spread over all of
+     its sub-pools - RootNode::trim() moves such a tree together (through a FlatTree) before trimming.
+
+    NodePool ownership
+     A pool belongs to the RootNode that holds it and is only ever used by one thread at a time: the
+     worker that owns the root (threadGenerator hands every population index to exactly one thread,
+     other roots are only read). Allocation and deallocation therefore take no locks at all.
+     Build with NODEPOOL_DEBUG (on in the build.sh debug mode) to verify the ownership - every pool access then tries the pool lock
+     and throws if two threads ever use the same pool at once.
+*/
+
 class NodePool { // custom memory pool manager
 public:
-    typedef std::array<uNode, 48> Pool; // define the cache pool size - 48 nodes should be sufficient for lower complexity values - this is a sub-pool and will be automatically allocated based on usage
+    static constexpr size_t BLOCK_SIZE = 1024; // bytes of one sub-pool - 42 compact nodes, which is sufficient for lower complexity values - further sub-pools are allocated based on usage
+    struct Pool; // sub-pool block - the owning RootNode followed by the node slots (see nodepool.h)
+    static const size_t POOL_NODES; // node slots of one sub-pool
+
+    struct Statistics {
+        size_t capacity, live, free; // node slots of all sub-pools / allocated / not allocated
+        size_t peak; // most nodes ever allocated at once
+    };
+
+    static inline const Pool* blockOf(const Node* node); // the sub-pool a node lives in
 
 private:
-    uNode* freeNode;
-    std::list<Pool*> memPool; // list of all memory sub-pools
-    Pool* curMemPool; // points to the current memory sub-pool in use (this should be the last memory sub-pool that was allocated)
-    std::mutex tsafe;
-    std::atomic<size_t> count;
+    RootNode* owner;
+    uNode* freeNode; // head of the singly linked list of freed slots
+    std::vector<Pool*> memPool; // list of all memory sub-pools
+    size_t curPool, used; // arena cursor - slots [0, used) of memPool[curPool] and every slot of the sub-pools before it have been handed out
+#ifdef NODEPOOL_DEBUG
+    std::mutex tsafe; // ownership check only - never waited on
+#endif
+    size_t count, peak; // only used by the owner thread
     static std::atomic<size_t> totalCount;
 
+    struct PendingNodes { // node count changes of one thread that are not in totalCount yet
+        long delta = 0;
+        ~PendingNodes(); // flushed when the thread exits
+    };
+    static thread_local PendingNodes pending;
+    static void trackNodes(long delta); // batched per thread so allocations don't fight over the shared counter
+
+    uNode* allocateSlot(); // pop a freed slot or take the next slot of the arena - adds a new sub-pool once all slots are used
+
 public:
 
-    uNode* preAllocateMemoryPool();
-    bool addLinkNewPool(uNode* lastNode);
+    uNode* preAllocateMemoryPool(); // allocate a new sub-pool at the end of the arena
 
     void deallocate_Node(Node* removeNode);
+    void reset(); // give back every node at once - O(1), the sub-pools are kept for the next tree
+    size_t trim(size_t maxNodes); // release the untouched sub-pools beyond maxNodes slots (the sub-pools in use are kept) - returns the released bytes
 
     OpNode* allocate_OpNode();
     VarNode* allocate_VarNode();
 
     inline size_t getNodeCount() { return count; }
-    inline static size_t getTotalNodeCount() { return totalCount; }
+    Statistics statistics() const;
+    size_t memoryUsage() const; // heap bytes of the sub-pools
+    static size_t getTotalNodeCount(); // exact once the workers have finished their tasks
+    static void flushNodeCount(); // add the node count changes of the calling thread to the total
 
-    NodePool();
+    NodePool(RootNode* owner);
     virtual ~NodePool();
 
     friend class RootNode; // this is for the validateNodeTree() to access private pool information
@@ -57,14 +97,21 @@ public:
     static const Parameters* params;
 
     float score, complexity;
+    bool rejected; // score is only a lower bound - scoring stopped early once it was worse than the survival cutoff
+    bool scored; // score (or rejection) belongs to the tree of formHash - cleared when the tree or its constants change
+    uint16_t home; // worker that allocated the root - it keeps working on the root with useNumaPlacement
     Node* node;
-    std::mutex* lock;
     std::string form;
+    uint64_t formHash; // FormSet::hash of the form - duplicate removal compares these
     NodePool pool;
+    NodeResults results; // results of the operator nodes over the dataset (only with incrementalCache)
 
     RootNode();
     virtual ~RootNode();
 
+    void reset(); // drop the tree, its results and score - every node goes back to the pool at once
+    size_t trim(double watermark); // shrink the pool to watermark times the live nodes - moves the tree together when it is spread too thin - returns the released bytes
+
 
     void computeEquation(Operators::EqPoints& data, double from, double to, double precision=0.01); // compute and get results
     void calculateForm(); // calculate form for node tree
@@ -87,5 +134,8 @@ public:
 };
 
 
+#ifdef REQUIRE_NODEPOOL
+#include "nodepool.h" // pool internals - only needed by the pool implementation
+#endif
 
 #endif // __EVO_ROOT_NODE__
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "operators.h"
 #include "nodetypes.h"
 #include "node.h"
+#include "program.h"
 #include <vector>
 #include <atomic>
 #include <mutex>
@@ -18,7 +19,7 @@ public:
         float score;
         std::vector<VTYPE> constants;
         Node* rcopy;
-        NodeList* rcList;
+        std::vector<Node*>* rcList; // constants of the root copy
     };
 
     typedef std::vector<NodeScore> Population;
@@ -26,12 +27,15 @@ public:
     const Parameters* params;
     Node* root, *cpRoot;
     Population population;
-    NodeList& rList;
+    NodeBuffer rConstants; // constant nodes of the root in preorder - the same order as the constants of a NodeScore
 
     Operators::EqPoints data;
+    Program program; // compiled root - constants are updated in place for each member of the population
 
-    Fitness(RootNode* rootnode, const Operators::EqPoints& odata, NodeList& rval);
+    Fitness(RootNode* rootnode, const Operators::EqPoints& odata);
     virtual ~Fitness();
+
+    static size_t takePeakMemory(); // most bytes held by the fitness runs at once since the last call
     
     void syncConstants(NodeScore& rt, bool toorig=false);
     void sortPopulation();
@@ -50,6 +54,9 @@ public:
 
     float run();
 
+private:
+    size_t bytes; // memory of this run - the population copies live in the root's node pool
+    static std::atomic<size_t> liveBytes, peakBytes;
 
 };
 
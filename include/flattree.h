@@ -0,0 +1,68 @@
+#ifndef __FLAT_TREE_H__
+#define __FLAT_TREE_H__
+
+#include "forward.h"
+#include "operators.h"
+#include "nodetypes.h"
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+/*  FlatTree: a node tree stored as one contiguous buffer linked by 16-bit indices
+
+     The slots are kept in preorder, so every subtree is one contiguous range of the buffer:
+        add(var0, mul(2.0, var1))  ->  [add | var0 | mul | 2.0 | var1]
+                                         0     1      2     3     4    (the subtree of mul is [2, 5))
+     Children and parent are indices into the same buffer instead of pointers, so a tree has no
+     addresses in it at all:
+        - copying a tree is a single memcpy
+        - a crossover is three memcpy's (head of a, subtree of b, tail of a) plus a pass that
+          shifts the indices of the moved ranges
+        - a tree can be written out, read back or handed to another root without a deep walk
+     A tree holds at most 65535 slots. build() turns a flat tree back into pool nodes of a RootNode.
+*/
+
+class FlatTree {
+public:
+    typedef uint16_t Index;
+    static constexpr Index NIL = 0xFFFF; // no parent or no child
+    static constexpr size_t MAX_NODES = NIL;
+
+    struct Slot {
+        uint8_t name;      // NodeTypes::FunctionName
+        int8_t arity;      // number of children
+        Index parent;      // NIL for the root
+        Index children[2]; // NIL when unused
+        VTYPE value;       // variables and constants
+    };
+
+    FlatTree();
+    FlatTree(const Node* root);
+
+    void assign(const Node* root); // flatten a pointer tree
+    void assign(const Slot* data, size_t count); // load raw slots (a tree written out with data())
+    Node* build(RootNode* root) const; // rebuild the tree as nodes of the root's pool
+
+    void crossover(const FlatTree& a, Index at, const FlatTree& b, Index from); // become a with the subtree at replaced by the subtree from of b
+
+    Index subtreeEnd(Index i) const; // one past the last slot of the subtree of i
+    inline size_t size() const { return slots.size(); }
+    inline bool empty() const { return slots.empty(); }
+    inline const Slot& operator[](Index i) const { return slots[i]; }
+    inline const Slot* data() const { return slots.data(); }
+
+    VTYPE compute(const Operators::Variables& vars, Index i=0) const;
+    std::string string(Index i=0) const; // same format as Node::string()
+
+private:
+    std::vector<Slot> slots;
+
+    Index flatten(const Node* node, Index parent);
+    Node* build(RootNode* root, Index i) const;
+};
+
+static_assert(sizeof(FlatTree::Slot) == 16, "a flat slot is two 8-byte words");
+
+
+#endif // __FLAT_TREE_H__
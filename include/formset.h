@@ -0,0 +1,41 @@
+#ifndef __FORM_SET_H__
+#define __FORM_SET_H__
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+/*  FormSet: concurrent set of 64-bit form hashes
+
+     Duplicate removal only has to know whether a form was seen before in this generation, so the
+     set keeps the hashes of the forms and never the strings. It is an open addressing table with
+     linear probing that is at least twice as large as the number of forms it was reset for. A slot
+     goes from empty to its hash with one CAS and is never changed again until the next reset, so
+     any number of workers can insert at the same time:
+        insert(h)  ->  true: first insert of h     false: h was already in the set
+     Two different forms with the same 64-bit hash count as duplicates - with a population of
+     10^6 that happens about once in 3 * 10^7 generations and only costs an extra mutation.
+*/
+
+class FormSet {
+public:
+    FormSet();
+
+    void reset(size_t count); // empty the set for up to count forms
+    bool insert(uint64_t hash); // thread safe - false if the hash was already in the set
+
+    static uint64_t hash(const std::string& form);
+
+    inline size_t capacity() const { return slots; }
+    size_t memoryUsage() const; // heap bytes of the table
+
+private:
+    std::unique_ptr<std::atomic<uint64_t>[]> table; // 0 is an empty slot
+    size_t slots, limit; // table size (a power of two) / forms it holds at most
+    std::atomic<size_t> count;
+};
+
+
+#endif // __FORM_SET_H__
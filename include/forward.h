@@ -9,14 +9,15 @@ class NodePool;
 class Node;
 class VarNode;
 class OpNode;
-struct NodeList;
+class NodeBuffer;
+class NodeCursor;
 struct Value;
 
 extern const Value NOVALUE;
 
 class RootNode;
 class NodePool;
-struct uNode;
+union uNode;
 
 class EvoAlgo;
 
@@ -0,0 +1,73 @@
+#ifndef __INTERVAL_H__
+#define __INTERVAL_H__
+
+#include "forward.h"
+#include "operators.h"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+/*  IntervalScreen: interval arithmetic pre-screen of new trees
+
+     Every variable is bounded by the min/max of its column, so a whole tree can be evaluated
+     once over intervals instead of once per point. The result bounds every value the tree can
+     produce on the dataset:
+        add(var0, 2.0) with var0 in [-1, 3]  ->  [1, 5]
+        pow(neg(abs(var0)), 0.5)             ->  NaN on every point
+
+     Two kinds of trees never need a full evaluation:
+        - trees that are NaN on every point - their score is INFINITY no matter what
+        - trees that are constant - their score follows from the sums of the point results
+     Everything else (including trees that are only NaN on some points) is scored normally.
+     The arithmetic is conservative: anything the rules cannot bound becomes [-inf, inf].
+*/
+
+struct Interval {
+    VTYPE lo, hi; // bounds of the non-NaN values - lo > hi means there are none
+    bool nan;     // the value may be NaN
+
+    static Interval point(VTYPE value);
+    static Interval whole(bool nan); // [-inf, inf]
+    static Interval alwaysNaN();
+
+    inline bool isPoint() const { return lo == hi && !nan; }
+    inline bool isNaN() const { return !(lo <= hi) && nan; } // NaN on every point
+    inline bool contains(VTYPE value) const { return lo <= value && value <= hi; }
+};
+
+class IntervalScreen {
+public:
+    enum Verdict {
+        EVALUATE,   // needs a full evaluation
+        ALWAYS_NAN, // NaN on every point
+        CONSTANT_VALUE // same value on every point
+    };
+
+    struct Statistics {
+        size_t screened, nan, constant;
+        size_t saved; // point evaluations that were not needed
+    };
+
+    IntervalScreen();
+
+    void reset(const Operators::EqPoints& data); // bound the variables of a dataset and sum its results
+    void resetStatistics();
+
+    Interval evaluate(const Node* node) const; // bounds of the subtree over the dataset
+    Verdict screen(const Node* root, float& score); // sets the exact score unless the tree has to be evaluated (thread safe)
+
+    Statistics statistics() const;
+    std::string report() const; // one line summary of the statistics
+
+private:
+    std::vector<Interval> variables; // bounds of every variable column
+    double sum, sumSquares; // sums of the clamped point results
+    size_t numPoints;
+    std::atomic<size_t> screened, nan, constant;
+
+    float constantScore(VTYPE value) const; // RMS score of a tree that is value on every point
+};
+
+
+#endif // __INTERVAL_H__
@@ -0,0 +1,30 @@
+#ifndef __MEMORY_REPORT_H__
+#define __MEMORY_REPORT_H__
+
+#include <cstddef>
+#include <string>
+
+/*  MemoryReport: bytes owned by the evolution engine, by subsystem
+
+     Every number is counted from the containers themselves (capacity, not size) instead of being
+     estimated, so the total can be held against the memoryBudget parameter.
+        nodePools    - the node sub-pools of the population, the shadow population and the scratch roots
+        rootNodes    - the RootNode objects and the population arrays
+        compactTrees - the encoded trees and individual records of the compact population
+        formStrings  - heap memory of the form strings (short forms live inside the RootNode)
+        nodeResults  - peak of the incremental node results since the last report and their lookup tables
+        subtreeCache - peak of the results shared by the population since the last report
+        fitness      - peak memory of the fitness runs since the last report
+        datasets     - the point data and every copy of it (float copy, racing order)
+        visual       - the graph drawing surfaces
+*/
+
+struct MemoryReport {
+    size_t nodePools, rootNodes, compactTrees, formStrings, nodeResults, subtreeCache, fitness, datasets, visual;
+
+    size_t total() const;
+    std::string string() const; // one line summary in MB
+};
+
+
+#endif // __MEMORY_REPORT_H__
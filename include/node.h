@@ -6,11 +6,39 @@ class NodePool;
 class Node;
 class VarNode;
 class OpNode;
-struct NodeList;
+class NodeBuffer;
+class NodeCursor;
 struct Value;
 
 typedef Node* Children[2];
 
+#include <vector>
+#include <stddef.h>
+
+/*  Tree traversal without allocations
+     NodeCursor walks a subtree in preorder with an explicit stack and skips the kinds it is not asked for:
+        for(NodeCursor c(root, Node::KIND_CONSTANT); Node* n = c.next();) ...
+     Node::collect() gathers the nodes of a subtree for random picks. Both use NodeBuffer scratch
+     vectors: every thread keeps the buffers it used before, so once they have grown to the largest
+     tree nothing is allocated anymore. Buffers may be held in any order and nested freely.
+*/
+
+class NodeBuffer {
+public:
+    NodeBuffer();  // borrow a cleared buffer of this thread
+    ~NodeBuffer(); // give it back
+    NodeBuffer(const NodeBuffer&) = delete;
+    NodeBuffer& operator=(const NodeBuffer&) = delete;
+
+    inline std::vector<Node*>& operator*() { return *buffer; }
+    inline std::vector<Node*>* operator->() { return buffer; }
+    inline const std::vector<Node*>* operator->() const { return buffer; }
+    inline Node* operator[](size_t i) const { return (*buffer)[i]; }
+
+private:
+    std::vector<Node*>* buffer;
+};
+
 #include "evorootnode.h"
 #include "nodetypes.h"
 #include "operators.h"
@@ -20,6 +48,7 @@ typedef Node* Children[2];
 #include "debug.h"
 #include "hexstring.h"
 #include "valuetype.h"
+#include "program.h"
 
 
 #include <iostream>
@@ -30,17 +59,25 @@ typedef Node* Children[2];
 #include <cstring>
 #include <cmath>
 #include <array>
+#include <bit>
 #include <stdint.h>
 
 
 #define WARNING_BAD_CALL(x) warning("Calling "#x" method without an OpNode!")
 
-struct NodeList {
-    std::vector<Node*> operators, variables, constants, all;
-
-    NodeList& operator+=(const NodeList& rs);
-
-};
+/*  Compact node layout
+     A node is a plain 24-byte record without a vtable:
+        [ name | arity | parent (48 bit) ]  8 bytes
+        [ children[0] | children[1] ]      16 bytes   (operators)
+        [ value                     ]      16 bytes   (variables and constants share the same space)
+     OpNode and VarNode are views over the same record - they add no data, so a Node* can be cast to
+     either one depending on its name. Everything that used to be virtual dispatches on the name.
+     The root of a node is found through the pool block the node lives in, and the operator function
+     comes from the operator table, so neither has to be stored per node.
+     The parent keeps the low 6 bytes of its address, which limits the layout to little endian 64-bit
+     targets with 48-bit user space addresses (x86-64, AArch64 without 52-bit VA). NodePool checks every
+     block it allocates and throws if a node address would not fit.
+*/
 
 class Node {
 protected:
@@ -49,6 +86,8 @@ protected:
 
     friend class RootNode; // Root node must be able to access all private members
     friend class NodePool; // Root node must be able to access all private members
+
+    void coutLinks(int level) const; // parent and child links shared by both node kinds
 public:
 
     enum ReasonCode {
@@ -60,37 +99,49 @@ public:
         SUCCESS
     };
 
+    enum Kind : uint8_t { // node kinds for filtered traversals - combine with |
+        KIND_OPERATOR = 1, KIND_VARIABLE = 2, KIND_CONSTANT = 4,
+        KIND_ALL = KIND_OPERATOR | KIND_VARIABLE | KIND_CONSTANT
+    };
+
     static std::atomic<size_t> debugSkippedSimplify;
 
-    uNode* memory; // pointer to the double linked list memory managed node space
-    Node* parent;
-    RootNode* rootNode;
     NodeTypes::FunctionName name;
-
-	Children children; // contains children nodes
 	int8_t arity;   // number of operators
-	//double complexity; // complexity of the sub-tree structure
+private:
+    uint8_t parentBits[6]; // parent pointer - user space addresses fit in 48 bits
+public:
+    union {
+	    Children children; // contains children nodes (operators)
+        Value value;       // variables and constants
+    };
 
-	virtual ~Node();
+    inline Node* parent() const { uint64_t p = 0; std::memcpy(&p, parentBits, sizeof(parentBits)); return reinterpret_cast<Node*>(p); }
+    RootNode* rootNode() const; // the root that owns the pool block this node lives in
+    inline bool isOperator() const { return name != NodeTypes::CONSTANT && name != NodeTypes::VARIABLE && name != NodeTypes::RANDOM_VAR; }
+    inline Kind kind() const { return isOperator() ? KIND_OPERATOR : name == NodeTypes::CONSTANT ? KIND_CONSTANT : KIND_VARIABLE; }
     
-    virtual ReasonCode validateNode() = 0;
+    ReasonCode validateNode();
     ReasonCode validateNodeTree(RootNode* rootnode);
     
-    virtual void free();
-    virtual void freeAll();
+    void free();
+    void freeAll();
 
     // an internal use - used by both fitness scoring and regular scoring
-    static float rmsCalculate(const std::vector<VTYPE>& actual, const std::vector<VTYPE>& results);
+    static float rmsCalculate(const Operators::EqPoints& points, const VTYPE* results); // results must hold one value per point
+    template<typename T> static void rmsAccumulate(const T* actual, const T* results, size_t len, float& sum); // add the clamped squared error of a range of points (double and float)
+    static float rmsFinalize(float sum, size_t len); // convert the accumulated squared error into the final score
     
     // testing and external use - disabled for offical use
     //static OpNode* addNode(NodeTypes::FunctionName name=NodeTypes::NONE, const Children& children={nullptr, nullptr}); // add an OpNode
     //static VarNode* addNode(NodeTypes::FunctionName name=NodeTypes::NONE, const Value& val=Value()); // add a VarNode
 
-    virtual inline Node* child(int idx) const { WARNING_BAD_CALL("child"); return nullptr; }
-    virtual inline OpNode* opchild(int idx) const { WARNING_BAD_CALL("opchild"); return nullptr; }
-    virtual inline VarNode* varchild(int idx) const { WARNING_BAD_CALL("varchild"); return nullptr; }
-    virtual inline void setchild(int idx, Node* c) { WARNING_BAD_CALL("setchild"); }
-    virtual inline void freechild(int idx, bool all=false) { WARNING_BAD_CALL("freechild"); }
+    inline Node* child(int idx) const { if(!isOperator()){ WARNING_BAD_CALL("child"); return nullptr; } return children[idx]; }
+    inline OpNode* opchild(int idx) const { if(!isOperator()){ WARNING_BAD_CALL("opchild"); return nullptr; } return reinterpret_cast<OpNode*>(children[idx]); }
+    inline VarNode* varchild(int idx) const { if(!isOperator()){ WARNING_BAD_CALL("varchild"); return nullptr; } return reinterpret_cast<VarNode*>(children[idx]); }
+    void setchild(int idx, Node* c);
+    void invalidate(); // drop the known results of this node and its parents after an edit
+    void freechild(int idx, bool all=false);
 
     /*
     inline bool operator>(const Node& rs) const { return complexity > rs.complexity; }
@@ -105,19 +156,22 @@ public:
     void updateLinks();
 
 
-    virtual Node* copy(RootNode* newRoot) const;
-    virtual Node* copyMutate(RootNode* newRoot, const Node* to, const Node* from) const; // copy a node with a branch mutation on from-node to to-node
-    virtual void changeOperator(NodeTypes::FunctionName fname) = 0; // all children must have a change operator
-    virtual void listOfNodes(NodeList& list) const;
+    Node* copy(RootNode* newRoot) const;
+    Node* copyMutate(RootNode* newRoot, const Node* to, const Node* from) const; // copy a node with a branch mutation on from-node to to-node
+    void changeOperator(NodeTypes::FunctionName fname);
+    void collect(std::vector<Node*>& nodes, uint8_t kinds=KIND_ALL) const; // append the nodes of my subtree in preorder (left to right)
+    size_t count(uint8_t kinds=KIND_ALL) const; // number of nodes in my subtree
 
-    virtual VTYPE compute(const Operators::Variables& vars) const = 0; // all children must have a compute method
-    virtual float score(const Operators::EqPoints& points=Parameters::Params()->points, bool evo=false);
+    VTYPE compute(const Operators::Variables& vars) const;
+    VTYPE compute(const Operators::EqPoints& points, size_t row) const; // one point read straight from the columns
+    float score(const Operators::EqPoints& points=Parameters::Params()->points, bool evo=false);
+    float score(const Operators::EqPoints& points, float bound, bool& rejected); // early-abort scoring - rejected once the score is proven to exceed bound
 
     Node* simplify();
 
-    virtual std::string string() const = 0; // all children need a convert-to-string method
-    virtual std::string form() const = 0; // all children need a convert-to-string method
-	virtual void cout(int level=0) const;
+    std::string string() const;
+    std::string form() const;
+	void cout(int level=0) const;
 };
 
 
@@ -130,24 +184,19 @@ protected:
     friend class RootNode; // Root node must be able to access all private members
     friend class NodePool; // Root node must be able to access all private members
 public:
-    Value value;
-    virtual ~VarNode() = default;
-
-    virtual ReasonCode validateNode();
+    ReasonCode validateNode();
 
     Value& setVal(VTYPE val);
     void randomizeValue();
 
-    virtual void changeOperator(NodeTypes::FunctionName name);
-
-    virtual Node* copy(RootNode* newRoot) const;
-    virtual void listOfNodes(NodeList& nodes) const;
+    void changeOperator(NodeTypes::FunctionName name);
 
-    virtual VTYPE compute(const Operators::Variables& vars) const;
+    VTYPE compute(const Operators::Variables& vars) const;
+    VTYPE compute(const Operators::EqPoints& points, size_t row) const;
 
-    virtual std::string string() const;
-    virtual std::string form() const;
-    virtual void cout(int level=0) const;
+    std::string string() const;
+    std::string form() const;
+    void cout(int level=0) const;
 };
 
 
@@ -161,34 +210,36 @@ protected:
     friend class RootNode; // Root node must be able to access all private members
     friend class NodePool; // Root node must be able to access all private members
 public:
-    Operators::func function;
-    
-    virtual ~OpNode();
+    Operators::func function() const; // operator function from the operator table
 
-    virtual ReasonCode validateNode();
+    ReasonCode validateNode();
 
 
     void swap();
-    virtual void free();
-    virtual void freeAll();
-
-    virtual inline Node* child(int idx) const { return children[idx]; }
-    virtual inline OpNode* opchild(int idx) const { return static_cast<OpNode*>(children[idx]); }
-    virtual inline VarNode* varchild(int idx) const { return static_cast<VarNode*>(children[idx]); }
-    virtual inline void setchild(int idx, Node* c) { children[idx] = c; if(c != nullptr) c->setParent(this); }
-    virtual inline void freechild(int idx, bool all=false) { if(children[idx] != nullptr){ if(all) children[idx]->freeAll(); else children[idx]->free(); children[idx] = nullptr; } }
 
+    void changeOperator(NodeTypes::FunctionName name);
+    std::string string() const;
+    std::string form() const;
 
-    virtual void changeOperator(NodeTypes::FunctionName name);
-    virtual std::string string() const;
-    virtual std::string form() const;
+    VTYPE compute(const Operators::Variables& vars) const;
+    VTYPE compute(const Operators::EqPoints& points, size_t row) const;
 
-    virtual void listOfNodes(NodeList& nodes) const;
+    void cout(int level=0) const;
+};
 
-    virtual VTYPE compute(const Operators::Variables& vars) const;
+class NodeCursor {
+public:
+    NodeCursor(const Node* root, uint8_t kinds=Node::KIND_ALL);
+    Node* next(); // next node in preorder - nullptr once the subtree is done
 
-    virtual void cout(int level=0) const;
+private:
+    NodeBuffer stack;
+    uint8_t kinds;
 };
 
+static_assert(sizeof(Node) == 24 && sizeof(OpNode) == sizeof(Node) && sizeof(VarNode) == sizeof(Node), "nodes are views over the same compact record");
+static_assert(sizeof(void*) == 8 && sizeof(uintptr_t) == 8, "the 48-bit parent pointer needs a 64-bit target");
+static_assert(std::endian::native == std::endian::little, "the 48-bit parent pointer stores the low 6 bytes of a little endian address");
+
 
 #endif 		// __NODE_H_
@@ -3,14 +3,24 @@
 
 #include "node.h"
 #include "evorootnode.h"
-#include <variant>
 
-class NodePool;
+union uNode { // a pool slot - links the free list while empty and holds an OpNode or VarNode while in use
+    uNode* next;
+    alignas(Node) unsigned char node[sizeof(Node)];
 
-struct uNode {  // double linked list node for memory management
-    uNode *p, *n;
-    std::variant<std::monostate, OpNode, VarNode> node;
+    uNode(): next(nullptr) {}
 };
 
+struct alignas(NodePool::BLOCK_SIZE) NodePool::Pool { // sub-pool block - aligned to its own size, so masking a node address finds its block
+    RootNode* owner;
+    std::array<uNode, (NodePool::BLOCK_SIZE - sizeof(RootNode*)) / sizeof(uNode)> nodes;
+};
+
+static_assert(sizeof(NodePool::Pool) == NodePool::BLOCK_SIZE, "a sub-pool must fill exactly one block");
+
+inline const NodePool::Pool* NodePool::blockOf(const Node* node) {
+    return reinterpret_cast<const Pool*>(reinterpret_cast<uintptr_t>(node) & ~uintptr_t(BLOCK_SIZE - 1));
+}
+
 
-#endif // __NODE_POOL_H__
\ No newline at end of file
+#endif // __NODE_POOL_H__
@@ -0,0 +1,54 @@
+#ifndef __NODERESULTS_H__
+#define __NODERESULTS_H__
+
+#include "forward.h"
+#include "operators.h"
+
+#include <unordered_map>
+#include <memory>
+#include <atomic>
+
+/*  NodeResults: per-individual results of every operator node over the dataset
+
+     Kept by each RootNode so a tree that only changed in one place does not have to be computed
+     from scratch again. Every edit (setchild, swap, changeOperator, setVal, free) invalidates the
+     edited node and the path above it - everything else stays valid.
+     Copies of a tree (copy, copyMutate) share the results of all unchanged subtrees, so a child
+     only computes the path from its crossover or mutation point up to the root.
+
+     Results are shared pointers to immutable columns, so sharing them costs nothing. The memory of
+     all results together is limited by a global budget - nodes computed beyond it are not kept.
+*/
+
+class NodeResults {
+public:
+    typedef std::shared_ptr<const Operators::Column> Result;
+
+    NodeResults();
+
+    inline bool empty() const { return results.empty(); }
+    inline const Operators::EqPoints* dataset() const { return points; } // dataset the results belong to
+
+    Result find(const Node* node) const;
+    void erase(const Node* node);
+    void invalidate(const Node* node, size_t maxDepth); // erase the node and all of its parents - simplify briefly links parents in a loop, so the walk is limited
+    void inherit(const Node* node, const NodeResults& source, const Node* original); // share the result of original (in source) with node
+    void clear();
+
+    Result evaluate(const Node* node, const Operators::EqPoints& points); // compute the node - keeps the result of every operator node below it
+
+    static void setMemoryBudget(size_t bytes);
+    static inline size_t memoryUsage() { return totalBytes; } // result columns of all individuals
+    static size_t takePeakMemory(); // most bytes of result columns alive at once since the last call
+    size_t tableUsage() const; // heap bytes of my node to result table (the columns are in memoryUsage)
+
+private:
+    std::unordered_map<const Node*, Result> results;
+    const Operators::EqPoints* points;
+
+    static std::atomic<size_t> totalBytes, peakBytes; // memory used by the results of all individuals
+    static size_t memoryBudget;
+};
+
+
+#endif // __NODERESULTS_H__
@@ -3,11 +3,12 @@
 
 #include <string>
 #include <vector>
+#include <stdint.h>
 
 namespace NodeTypes {
     typedef const std::vector<std::string> EnumStringMap;
     
-    enum FunctionName {
+    enum FunctionName : uint8_t {
         NONE, RANDOM_OP, RANDOM_VAR,
         CONSTANT, VARIABLE,
         INVERSE, NEGATIVE,
@@ -0,0 +1,27 @@
+#ifndef __NUMA_H__
+#define __NUMA_H__
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+/*  Numa: worker placement on multi-socket machines
+
+     The topology is read once from /sys/devices/system/node (Linux) - without it the machine is
+     treated as a single node. Workers are spread over the nodes in blocks:
+        2 nodes, 8 workers  ->  workers 0-3 on node 0, workers 4-7 on node 1
+     and every worker is pinned to one cpu of its node, so a worker index always runs on the same
+     socket. Memory is placed by first touch and glibc gives every thread its own malloc arena, so
+     whatever a pinned worker allocates lives on that worker's node.
+*/
+
+namespace Numa {
+
+    size_t nodeCount(); // number of NUMA nodes with cpus (at least 1)
+    size_t nodeOfWorker(size_t worker, size_t workers);
+    bool pinWorker(size_t worker, size_t workers); // pin the calling thread to a cpu of the worker's node - false if not supported
+    std::string topology(); // one line summary
+
+}
+
+#endif // __NUMA_H__
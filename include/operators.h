@@ -3,6 +3,8 @@
 
 #include <cmath>
 #include <vector>
+#include <new>
+#include <cstddef>
 #include <stdint.h>
 /**
  * 
@@ -17,31 +19,75 @@
 namespace Operators {
 
     typedef VTYPE (*func)(VTYPE x, VTYPE y); // function pointer for our operator functions
+    template<typename T> using basic_batchfunc = void (*)(const T* x, const T* y, T* out, size_t len); // function pointer for our array operator functions
+    typedef basic_batchfunc<VTYPE> batchfunc;
     
     struct Operator { // Operator contains the function pointer and the number of operands
         func function;
         int8_t arity;
     };
 
-    typedef std::vector<VTYPE> Variables; // Variables is a list of input variables for the equation function
+    template<typename T, size_t Alignment = 64>
+    struct AlignedAllocator { // allocator for column memory - every column starts on a cache line boundary
+        typedef T value_type;
+        template<typename U> struct rebind { typedef AlignedAllocator<U, Alignment> other; };
 
-/*  EqPoints structure
+        AlignedAllocator() = default;
+        template<typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        inline T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment))); }
+        inline void deallocate(T* p, size_t) { ::operator delete(p, std::align_val_t(Alignment)); }
+
+        template<typename U> inline bool operator==(const AlignedAllocator<U, Alignment>&) const { return true; }
+        template<typename U> inline bool operator!=(const AlignedAllocator<U, Alignment>&) const { return false; }
+    };
+
+    typedef std::vector<VTYPE> Variables; // Variables is a list of input variables for the equation function (a single point)
+    template<typename T> using BasicColumn = std::vector<T, AlignedAllocator<T>>; // BasicColumn is a contiguous list of values for every point
+    typedef BasicColumn<VTYPE> Column;
+
+/*  EqPoints structure (column-major)
      result <- F(x,y,z)
 
-     Points::points: [
-        [x, y, z], [x, y, z]...
+     Points::columns: [
+        [x, x, x...], [y, y, y...], [z, z, z...]
      ]
      Points::results: [
          result, result...
      ]
+
+     The scalar type is a template so the same points can be scored at a lower precision
+     (BasicEqPoints<float>) - EqPoints is the VTYPE version everything else uses.
 */
 
-    struct EqPoints { // EqPoints contains the list of pre-determined points and the actual calculated result for each point
+    template<typename T>
+    struct BasicEqPoints { // EqPoints contains the list of pre-determined points and the actual calculated result for each point
         int numVars; // number of variables the equation has (number of variables per point)
-        std::vector<Variables> points; // the list of points
-        Variables results; // the list of caluclated results for the given points
+        std::vector<BasicColumn<T>> columns; // one contiguous column of values per variable
+        BasicColumn<T> results; // the list of caluclated results for the given points
+
+        BasicEqPoints(): numVars(0) {}
+        template<typename U> explicit BasicEqPoints(const BasicEqPoints<U>& points): numVars(points.numVars), columns(points.columns.size()) { // convert the precision
+            for(size_t v=0; v < columns.size(); ++v) columns[v].assign(points.columns[v].begin(), points.columns[v].end());
+            results.assign(points.results.begin(), points.results.end());
+        }
+
+        inline size_t size() const { return results.size(); }
+        inline bool empty() const { return results.empty(); }
+        inline T at(size_t row, int var) const { return columns[var][row]; }
+
+        Variables point(size_t row) const; // gather a single point from every column
+        void addPoint(const Variables& vars, VTYPE result); // append a single point to every column
+        void resize(size_t rows); // resize every column to the number of rows (numVars must be set)
+        void clear();
+
+        BasicEqPoints subset(const std::vector<size_t>& rows) const; // copy of the given rows in the given order
+        void sortByVariable(int var); // reorder all points by the values of a variable
+        size_t memoryUsage() const; // heap bytes of the columns and results
     };
 
+    typedef BasicEqPoints<VTYPE> EqPoints;
+
     typedef std::vector< Operator > FunctionList;
 
 
@@ -57,6 +103,21 @@ namespace Operators {
     OPERATOR_DECL Cos(VTYPE x, VTYPE y);
     OPERATOR_DECL Tan(VTYPE x, VTYPE y);
 
+    /*  Batch Operators
+         Array versions of the operators above: out[i] = F(x[i], y[i]) for i < len
+         The scalar functions above stay the reference implementation - every double batch kernel must match them.
+         The float kernels compute the same formulas in single precision.
+         The best instruction set is picked at runtime from the CPU features.
+    */
+    enum BatchLevel {
+        BATCH_SCALAR, BATCH_SSE2, BATCH_AVX2, BATCH_AVX512
+    };
+
+    BatchLevel batchLevel(); // current batch instruction set
+    BatchLevel setBatchLevel(BatchLevel level); // force an instruction set (clamped to what the CPU supports) - returns the level in use
+    const char* batchLevelName(BatchLevel level);
+    template<typename T=VTYPE> basic_batchfunc<T> vectorize(func function); // get the batch kernel for a scalar operator - nullptr if there is none (double and float)
+
 }
 
 #endif // __OPERATORS_H_
\ No newline at end of file
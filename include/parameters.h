@@ -37,6 +37,16 @@ struct FitnessParameters {
 	double changeChance, sampleSize, cutOff;
 };
 
+struct CacheParameters {
+	bool use;
+	size_t memoryBudget; // megabytes
+};
+
+struct RacingParameters {
+	bool use;
+	double initialSample, growth, margin;
+};
+
 struct VisualParameters {
 	bool display, closeOnFinish;
 	uint32_t clearCount, xresolution, yresolution;
@@ -67,27 +77,34 @@ public:
 		CONSTANT,
 		OPERATOR
 	};
+	enum Precision {
+		PRECISION_DOUBLE,
+		PRECISION_FLOAT
+	};
 	// Internal Parameters - Converted Parameters
 	int decimalPlacesExp;
 	Operators::FunctionList operatorList;
 
 	// External Parameters
-	size_t popSize, generationCount, maxScoreHistory, mutationCount, targetComplexity, maxDuplicateRemoval, popSave;
+	size_t popSize, generationCount, maxScoreHistory, mutationCount, targetComplexity, maxDuplicateRemoval, popSave, memoryBudget;
     int decimalPlaces;
 	VTYPE maxConstant, minConstant, minRMSClamp, maxRMSClamp;
 	double defaultComplexity, survivalRatio, weightChance,
 		   constantChance, operatorChance, changeChance, mutationChance,
-		   parsimony, accuracy;
-	bool singleThreaded, weighedMutation, verboseLogging, useSqrtRMS, useRMSClamp, useCCMScoring, useVariableDescriptors;
+		   parsimony, accuracy, poolWatermark;
+	bool singleThreaded, weighedMutation, verboseLogging, useSqrtRMS, useRMSClamp, useCCMScoring, useVariableDescriptors, useCompiledScoring, useEarlyAbort, useIntervalScreen, useArenaReset, usePoolTrim, useNumaPlacement, useCompactPopulation, useWorkStealing, usePipeline;
 	
 	std::string precalculatedTree, defaultPointCloudCSV;
 
 	FitnessParameters fitness;
+	CacheParameters subtreeCache, incrementalCache;
+	RacingParameters racing;
 	VisualParameters visual;
 
 	std::vector<NodeTypes::FunctionName> operatorFunctions;
 	std::map<int, RootNode*> variableDescriptors;
 	int denySimplifyOperator;
+	Precision scoringPrecision; // scalar type used to score new children
 
 	Operators::EqPoints points; // may not be used internally
 
@@ -0,0 +1,79 @@
+#ifndef __PROGRAM_H__
+#define __PROGRAM_H__
+
+#include "forward.h"
+#include "operators.h"
+#include "nodetypes.h"
+#include "noderesults.h"
+
+#include <vector>
+#include <stdint.h>
+
+/*  Program: a node tree compiled into a flat postfix instruction list
+
+     add(var0, mul(2.0, var1)) compiles into:
+        [ var   0    -> s0 ]
+        [ const 0    -> s1 ]
+        [ var   1    -> s2 ]
+        [ mul s1, s2 -> s1 ]
+        [ add s0, s1 -> s0 ]
+
+     Each slot holds a block of results, so every instruction runs as one tight loop over
+     a block of points instead of one virtual call per node per point. Variable slots read
+     their EqPoints column directly.
+     Constants are indexed in the same left-to-right order as Node::collect(.., KIND_CONSTANT).
+     A COLUMN leaf stands in for a whole subtree whose results are already known (see SubtreeCache).
+
+     Scoring accumulates the squared error block by block. The partial sum can only grow, so a
+     bounded score gives up as soon as the partial score is past the bound.
+
+     The scalar type is a template: Program computes in VTYPE, FloatProgram computes in float
+     (twice the SIMD width and half the memory traffic) against a float copy of the points.
+*/
+
+template<typename T>
+class BasicProgram {
+public:
+    static constexpr size_t BLOCK_SIZE = 256; // number of points computed per instruction pass
+    static constexpr uint8_t COLUMN = 0xFF;   // leaf op of a precomputed subtree result - indexed into columns
+
+    struct Instruction {
+        uint8_t op;         // NodeTypes::FunctionName of the node
+        uint8_t arity;      // number of operands (0 for variables and constants)
+        uint16_t dst, a, b; // destination slot and operand slots
+        uint32_t index;     // variable index or constant index
+        Operators::func function; // operator function (nullptr for variables and constants)
+        Operators::basic_batchfunc<T> batch; // array version of the operator function (nullptr falls back to the scalar function)
+    };
+
+    std::vector<Instruction> code;
+    std::vector<T> constants;   // constant table - indexed by Instruction::index
+    std::vector<const T*> columns; // precomputed subtree results (one value per point) - indexed by Instruction::index of COLUMN leaves
+    uint16_t numSlots;
+
+    BasicProgram();
+    BasicProgram(const Node* root, const NodeResults* known=nullptr);
+
+    void compile(const Node* root, const NodeResults* known=nullptr); // (re)compile the given tree - nodes with known results become COLUMN leaves (known must outlive the program and is ignored for float)
+    inline bool empty() const { return code.empty(); }
+    inline size_t memoryUsage() const { return code.capacity() * sizeof(Instruction) + constants.capacity() * sizeof(T) + columns.capacity() * sizeof(const T*); } // heap bytes
+
+    T compute(const Operators::Variables& vars) const; // compute a single point
+    void computeBlock(const Operators::BasicEqPoints<T>& points, size_t from, size_t to, T* out) const; // compute points [from, to) into out
+    void computeAll(const Operators::BasicEqPoints<T>& points, Operators::BasicColumn<T>& results) const; // compute every point
+
+    float score(const Operators::BasicEqPoints<T>& points) const; // RMS score against the point results
+    float score(const Operators::BasicEqPoints<T>& points, float bound, bool& rejected) const; // stops once the score is proven to exceed bound - a rejected score is only a lower bound
+    void accumulate(const Operators::BasicEqPoints<T>& points, size_t from, size_t to, float& sum) const; // add the squared error of points [from, to) to sum (variables are not checked)
+    void checkVariables(const Operators::BasicEqPoints<T>& points) const; // warn about variable indices beyond the point data
+
+private:
+    uint16_t emit(const Node* node, uint16_t slot, const NodeResults* known); // recursive postfix emitter - returns the highest slot used
+    void evaluate(const Operators::BasicEqPoints<T>& points, size_t start, size_t len, T* out) const; // compute one block of at most BLOCK_SIZE points
+};
+
+typedef BasicProgram<VTYPE> Program;
+typedef BasicProgram<float> FloatProgram;
+
+
+#endif // __PROGRAM_H__
@@ -0,0 +1,75 @@
+#ifndef __RACING_H__
+#define __RACING_H__
+
+#include "program.h"
+#include "operators.h"
+
+#include <vector>
+#include <string>
+
+/*  Racing: progressive sampling of the new children
+
+     Instead of scoring every child on every point, all racers are scored on a small random
+     sample first. Racers whose sample score is clearly worse than the field are eliminated and
+     the rest are promoted to the next, larger sample - until the survivors are scored on the
+     full dataset.
+        stage 0: [0, n)  stage 1: [n, n*g)  stage 2: [n*g, n*g*g) ... [.., size)
+
+     The points are shuffled once per generation, so every sample is a prefix of the same random
+     order. A promoted racer only computes the points of its new stage and keeps adding to the
+     squared error sum it already has - no point is evaluated twice.
+
+     A racer is eliminated when its sample score is beyond margin times the better of:
+        - the survival cutoff of the previous generation
+        - the sample score of the racer ranked at the number of survivors
+     The sample score only ranks the racers inside the race - it is not a bound of the full score.
+     Eliminated racers are marked as rejected and keep the error of their sample spread over every
+     point, a lower bound of the full score that select() can rank with complete scores. Racers that
+     are proven worse than the bound (like early abort) or whose error is already NaN stop as well.
+*/
+
+class Racing {
+public:
+    struct Statistics {
+        size_t racers, eliminated;
+        size_t evaluated, baseline; // points computed vs points a full evaluation of every racer computes
+    };
+
+    Racing();
+
+    void reset(const Operators::EqPoints& data, double initialSample, double growth); // draw a new random order of the points and plan the stages
+    void begin(size_t numRacers, float bound); // start a race - racers proven worse than bound stop early (INFINITY disables it)
+
+    void advance(size_t racer, const Node* root); // score the racer on the points of the current stage (thread safe for different racers)
+    void finish(size_t racer, float score); // stop a racer whose exact score is already known
+    void eliminate(size_t survivors, double margin, float cutoff); // drop the racers that are clearly worse than the field
+    bool nextStage(); // false once the last stage is done
+    inline bool firstStage() const { return stage == 0; }
+
+    float score(size_t racer, bool& rejected) const; // final score of a racer - a lower bound once rejected
+
+    Statistics statistics() const;
+    std::string report() const; // one line summary of the statistics
+    size_t memoryUsage() const; // heap bytes of the shuffled points and the racers
+
+private:
+    struct Racer {
+        Program program;
+        float sum;       // squared error of the points computed so far
+        size_t computed; // number of points computed so far
+        float score;     // set once the racer stops
+        bool running, rejected;
+    };
+
+    Operators::EqPoints points; // shuffled copy of the data
+    std::vector<size_t> stages; // end of every stage
+    std::vector<Racer> racers;
+    size_t stage;
+    float bound;
+    Statistics stats;
+
+    inline size_t stageBegin() const { return stage ? stages[stage - 1] : 0; }
+};
+
+
+#endif // __RACING_H__
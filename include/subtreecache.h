@@ -0,0 +1,77 @@
+#ifndef __SUBTREECACHE_H__
+#define __SUBTREECACHE_H__
+
+#include "program.h"
+#include "operators.h"
+
+#include <unordered_map>
+#include <memory>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+/*  SubtreeCache: results of common subtrees shared by the whole population
+
+     Children are crossover copies of the survivors, so the survivors' subtrees show up over and
+     over again. store() computes every operator subtree of a program over the full dataset and
+     keeps the results, keyed by the exact postfix encoding of the subtree (operators, variable
+     indices and constant bits).
+     score() looks up the subtrees of another program from the top down and replaces every hit with
+     a COLUMN leaf, so only the new parts of the tree are computed - and early abort still works.
+
+     The cache is bound to one dataset and is meant to be reset every generation. Once the memory
+     budget is used up new results are no longer stored. Every shard has its own lock so worker
+     threads rarely wait on each other.
+*/
+
+class SubtreeCache {
+public:
+    typedef std::shared_ptr<const Operators::Column> Result;
+
+    struct Statistics {
+        size_t hits, misses, skipped; // skipped results did not fit into the memory budget
+        size_t entries, bytes;
+    };
+
+    SubtreeCache(size_t numShards=64);
+
+    void reset(const Operators::EqPoints* points, size_t memoryBudget); // drop all results and bind the cache to a dataset
+    void clear(); // drop all results (keeps the dataset)
+
+    Result find(const std::string& key);
+    Result insert(const std::string& key, Operators::Column&& result); // returns the stored result (or the one already stored by another thread)
+
+    void store(const Program& program); // compute and keep every operator subtree of the program
+    float score(const Program& program, const Operators::EqPoints& points, float bound, bool& rejected); // same as Program::score but reuses cached subtrees
+
+    Statistics statistics() const;
+    std::string report() const; // one line summary of the statistics
+    size_t takePeakMemory(); // most bytes held by the results at once since the last call - clear() does not reset it
+
+private:
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<std::string, Result> results;
+    };
+
+    // postfix encoding of a program - keys and first instruction of the subtree ending at each instruction
+    struct Encoding {
+        std::vector<std::string> keys;
+        std::vector<size_t> starts;
+        Encoding(const Program& program);
+    };
+
+    std::vector<Shard> shards;
+    const Operators::EqPoints* points; // dataset the results belong to
+    size_t memoryBudget; // bytes
+    std::atomic<size_t> hits, misses, skipped, entries, bytes, peakBytes;
+
+    inline Shard& shard(const std::string& key) { return shards[std::hash<std::string>()(key) % shards.size()]; }
+
+    Result evaluate(const Program& program, const Encoding& encoding, size_t i); // compute (and store) the subtree ending at instruction i
+    void splice(const Program& program, const Encoding& encoding, size_t i, Program& out, std::vector<Result>& used); // copy the subtree ending at i - cached subtrees become COLUMN leaves
+};
+
+
+#endif // __SUBTREECACHE_H__
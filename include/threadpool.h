@@ -0,0 +1,79 @@
+#ifndef __THREAD_POOL_H__
+#define __THREAD_POOL_H__
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <cstdint>
+#include <string>
+
+/*  ThreadPool: worker threads that live as long as the pool
+
+     Every phase of a generation used to spawn and join its own threads. The pool keeps them
+     parked on a condition variable instead and wakes them for each task:
+        pool.dispatch(n, task);   // task(0) .. task(n - 1) start on workers 0 .. n-1
+        pool.wait();              // completion barrier - rethrows the first exception of a task
+        pool.run(n, task);        // both in one call
+     Worker i is always the same thread, so per-thread state (thread_local scratch buffers, NUMA
+     pinning) carries over from one task to the next. The pool grows to the largest worker count
+     it was asked for - workers beyond n are not even woken. Only one task runs at a time and
+     tasks must not dispatch onto their own pool.
+
+    Work stealing
+     forEach() hands out single items instead of whole workers. Every worker starts with its own
+     block of items and takes chunks from the front of it. A worker whose block is empty steals the
+     back half of the fullest-looking block of another worker, so nobody idles while work is left.
+     With costs the items are sorted by cost and dealt round robin before the blocks are cut:
+        costs 9 7 5 4 2 1, 2 workers  ->  worker 0: 9 5 2   worker 1: 7 4 1
+     Every block starts with its heaviest items and thieves take the light ones from the back.
+     Each item runs exactly once, on one worker.
+*/
+
+class ThreadPool {
+public:
+    typedef std::function<void(size_t worker)> Task;
+    typedef std::function<void(size_t item)> Item;
+
+    struct Statistics {
+        double wall, busy; // milliseconds of the whole task / summed over the workers while running items
+        size_t workers, items, steals;
+
+        inline double utilization() const { return wall > 0 && workers ? busy / (wall * workers) : 1; }
+        std::string string() const; // one line summary
+    };
+
+    ThreadPool();
+    virtual ~ThreadPool(); // finishes the running task and joins the workers
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void dispatch(size_t workers, const Task& task); // start the task on the first workers - returns immediately
+    void wait(); // wait until every worker of the last dispatch is done
+    inline void run(size_t workers, const Task& task) { dispatch(workers, task); wait(); }
+    Statistics forEach(size_t workers, size_t count, const Item& item, const std::vector<double>* costs=nullptr); // item(0) .. item(count - 1) with work stealing - heavy items first with costs
+
+    static size_t workerIndex(); // worker of the calling thread - 0 outside of a pool
+
+    size_t size(); // number of worker threads
+
+private:
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::deque<std::condition_variable> wake; // one per worker - only the workers of a task are woken
+    std::condition_variable done;
+    Task task;
+    size_t active, remaining; // workers of the current task / workers still running it
+    uint64_t epoch; // task counter - a worker runs every epoch it has not seen yet
+    bool stopping;
+    std::exception_ptr error; // first exception thrown by the current task
+
+    void loop(size_t index, uint64_t seen);
+};
+
+
+#endif // __THREAD_POOL_H__
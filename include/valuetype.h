@@ -8,10 +8,8 @@ struct Value {
 
     Value();
     Value(VTYPE val);
-    Value(const Value& val);
 
     Value& operator=(double rs);
-    Value& operator=(const Value& rs);
 };
 
 extern const Value NOVALUE;
\ No newline at end of file
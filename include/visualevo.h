@@ -36,6 +36,7 @@ public:
         void drawAxis(); // draw the graph axis (this is automatically drawn)
         void drawAdd(const Operators::EqPoints &points, uint32_t varIndex=0, const olc::Pixel& color=0xFFFFFFFF, const DrawType& type=LINES); // add computed graph data
         void drawClear(); // clear graph data
+        size_t memoryUsage() const; // bytes of the drawing surface
     };
 
     typedef std::shared_ptr<VisualEvo::Graph> GraphPtr;
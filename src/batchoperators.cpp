@@ -0,0 +1,224 @@
+#include "operators.h"
+
+#include <atomic>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    #define BATCH_X86
+    #include <immintrin.h>
+
+    #define ISA_SSE2 __attribute__((target("sse2")))
+    #define ISA_AVX2 __attribute__((target("avx2")))
+    #define ISA_AVX512 __attribute__((target("avx512f")))
+#endif
+
+/*
+    Batch Operators - array kernels for every operator in operators.cpp
+
+    Each instruction set gets its own copy of the kernels (in double and float) and the best one
+    supported by the running CPU is selected once at runtime. Operators without a vector instruction
+    (pow and the trigonometric functions) share a plain loop over the standard library at every level.
+*/
+
+namespace Operators {
+
+    // Inline scalar forms - the double versions must match the reference functions in operators.cpp exactly
+    namespace Scalar {
+        template<typename T> inline T inverse(T x, T) { return T(1) / x; }
+        template<typename T> inline T negative(T x, T) { return T(-1) * x; }
+        template<typename T> inline T add(T x, T y) { return x + y; }
+        template<typename T> inline T subtract(T x, T y) { return x - y; }
+        template<typename T> inline T multiply(T x, T y) { return x * y; }
+        template<typename T> inline T divide(T x, T y) { return (y == 0) ? T(0) : x / y; }
+        template<typename T> inline T power(T x, T y) { return std::pow(x, y); }
+        template<typename T> inline T abs(T x, T) { return std::abs(x); }
+        template<typename T> inline T sin(T x, T) { return std::sin(x); }
+        template<typename T> inline T cos(T x, T) { return std::cos(x); }
+        template<typename T> inline T tan(T x, T) { return std::tan(x); }
+    }
+
+    // Kernel generator: runs the vector expression over full vector widths and the scalar form over the tail
+    #define BATCH_KERNEL(NAME, ISA, T, V, WIDTH, LOAD, STORE, EXPR, SCALAR) \
+        ISA static void NAME(const T* x, const T* y, T* out, size_t len) { \
+            size_t i = 0; \
+            for(; i + WIDTH <= len; i += WIDTH){ \
+                V a = LOAD(x + i), b = LOAD(y + i); (void)b; \
+                STORE(out + i, EXPR); \
+            } \
+            for(; i < len; ++i) out[i] = SCALAR<T>(x[i], y[i]); \
+        }
+
+    template<typename T>
+    struct KernelTable {
+        basic_batchfunc<T> inverse, negative, add, subtract, multiply, divide, power, abs, sin, cos, tan;
+    };
+
+    // Shared plain loops - used by every level for operators without vector instructions
+    namespace Loop {
+        template<typename T, T (*SCALAR)(T, T)>
+        static void kernel(const T* x, const T* y, T* out, size_t len) {
+            for(size_t i = 0; i < len; ++i) out[i] = SCALAR(x[i], y[i]);
+        }
+
+        template<typename T>
+        static const KernelTable<T> table {
+            kernel<T, Scalar::inverse<T>>, kernel<T, Scalar::negative<T>>, kernel<T, Scalar::add<T>>, kernel<T, Scalar::subtract<T>>,
+            kernel<T, Scalar::multiply<T>>, kernel<T, Scalar::divide<T>>, kernel<T, Scalar::power<T>>, kernel<T, Scalar::abs<T>>,
+            kernel<T, Scalar::sin<T>>, kernel<T, Scalar::cos<T>>, kernel<T, Scalar::tan<T>>
+        };
+
+        template<typename T> static constexpr basic_batchfunc<T> Power = kernel<T, Scalar::power<T>>;
+        template<typename T> static constexpr basic_batchfunc<T> Sin = kernel<T, Scalar::sin<T>>;
+        template<typename T> static constexpr basic_batchfunc<T> Cos = kernel<T, Scalar::cos<T>>;
+        template<typename T> static constexpr basic_batchfunc<T> Tan = kernel<T, Scalar::tan<T>>;
+    }
+
+#ifdef BATCH_X86
+
+    namespace SSE2 {
+        #define SSE2_KERNEL(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_SSE2, double, __m128d, 2, _mm_loadu_pd, _mm_storeu_pd, EXPR, SCALAR)
+        #define SSE2_KERNEL_F(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_SSE2, float, __m128, 4, _mm_loadu_ps, _mm_storeu_ps, EXPR, SCALAR)
+
+        SSE2_KERNEL(Inverse, _mm_div_pd(_mm_set1_pd(1), a), Scalar::inverse)
+        SSE2_KERNEL(Negative, _mm_mul_pd(_mm_set1_pd(-1), a), Scalar::negative)
+        SSE2_KERNEL(Add, _mm_add_pd(a, b), Scalar::add)
+        SSE2_KERNEL(Subtract, _mm_sub_pd(a, b), Scalar::subtract)
+        SSE2_KERNEL(Multiply, _mm_mul_pd(a, b), Scalar::multiply)
+        SSE2_KERNEL(Divide, _mm_and_pd(_mm_div_pd(a, b), _mm_cmpneq_pd(b, _mm_setzero_pd())), Scalar::divide) // SSE2 has no blend - mask the quotient instead
+        SSE2_KERNEL(Abs, _mm_andnot_pd(_mm_set1_pd(-0.0), a), Scalar::abs)
+
+        SSE2_KERNEL_F(InverseF, _mm_div_ps(_mm_set1_ps(1), a), Scalar::inverse)
+        SSE2_KERNEL_F(NegativeF, _mm_mul_ps(_mm_set1_ps(-1), a), Scalar::negative)
+        SSE2_KERNEL_F(AddF, _mm_add_ps(a, b), Scalar::add)
+        SSE2_KERNEL_F(SubtractF, _mm_sub_ps(a, b), Scalar::subtract)
+        SSE2_KERNEL_F(MultiplyF, _mm_mul_ps(a, b), Scalar::multiply)
+        SSE2_KERNEL_F(DivideF, _mm_and_ps(_mm_div_ps(a, b), _mm_cmpneq_ps(b, _mm_setzero_ps())), Scalar::divide)
+        SSE2_KERNEL_F(AbsF, _mm_andnot_ps(_mm_set1_ps(-0.0f), a), Scalar::abs)
+
+        static const KernelTable<double> table {Inverse, Negative, Add, Subtract, Multiply, Divide, Loop::Power<double>, Abs, Loop::Sin<double>, Loop::Cos<double>, Loop::Tan<double>};
+        static const KernelTable<float> tableF {InverseF, NegativeF, AddF, SubtractF, MultiplyF, DivideF, Loop::Power<float>, AbsF, Loop::Sin<float>, Loop::Cos<float>, Loop::Tan<float>};
+    }
+
+    namespace AVX2 {
+        #define AVX2_KERNEL(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_AVX2, double, __m256d, 4, _mm256_loadu_pd, _mm256_storeu_pd, EXPR, SCALAR)
+        #define AVX2_KERNEL_F(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_AVX2, float, __m256, 8, _mm256_loadu_ps, _mm256_storeu_ps, EXPR, SCALAR)
+
+        AVX2_KERNEL(Inverse, _mm256_div_pd(_mm256_set1_pd(1), a), Scalar::inverse)
+        AVX2_KERNEL(Negative, _mm256_mul_pd(_mm256_set1_pd(-1), a), Scalar::negative)
+        AVX2_KERNEL(Add, _mm256_add_pd(a, b), Scalar::add)
+        AVX2_KERNEL(Subtract, _mm256_sub_pd(a, b), Scalar::subtract)
+        AVX2_KERNEL(Multiply, _mm256_mul_pd(a, b), Scalar::multiply)
+        AVX2_KERNEL(Divide, _mm256_blendv_pd(_mm256_setzero_pd(), _mm256_div_pd(a, b), _mm256_cmp_pd(b, _mm256_setzero_pd(), _CMP_NEQ_UQ)), Scalar::divide) // blend 0 wherever y == 0
+        AVX2_KERNEL(Abs, _mm256_andnot_pd(_mm256_set1_pd(-0.0), a), Scalar::abs)
+
+        AVX2_KERNEL_F(InverseF, _mm256_div_ps(_mm256_set1_ps(1), a), Scalar::inverse)
+        AVX2_KERNEL_F(NegativeF, _mm256_mul_ps(_mm256_set1_ps(-1), a), Scalar::negative)
+        AVX2_KERNEL_F(AddF, _mm256_add_ps(a, b), Scalar::add)
+        AVX2_KERNEL_F(SubtractF, _mm256_sub_ps(a, b), Scalar::subtract)
+        AVX2_KERNEL_F(MultiplyF, _mm256_mul_ps(a, b), Scalar::multiply)
+        AVX2_KERNEL_F(DivideF, _mm256_blendv_ps(_mm256_setzero_ps(), _mm256_div_ps(a, b), _mm256_cmp_ps(b, _mm256_setzero_ps(), _CMP_NEQ_UQ)), Scalar::divide)
+        AVX2_KERNEL_F(AbsF, _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a), Scalar::abs)
+
+        static const KernelTable<double> table {Inverse, Negative, Add, Subtract, Multiply, Divide, Loop::Power<double>, Abs, Loop::Sin<double>, Loop::Cos<double>, Loop::Tan<double>};
+        static const KernelTable<float> tableF {InverseF, NegativeF, AddF, SubtractF, MultiplyF, DivideF, Loop::Power<float>, AbsF, Loop::Sin<float>, Loop::Cos<float>, Loop::Tan<float>};
+    }
+
+    namespace AVX512 {
+        #define AVX512_KERNEL(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_AVX512, double, __m512d, 8, _mm512_loadu_pd, _mm512_storeu_pd, EXPR, SCALAR)
+        #define AVX512_KERNEL_F(NAME, EXPR, SCALAR) BATCH_KERNEL(NAME, ISA_AVX512, float, __m512, 16, _mm512_loadu_ps, _mm512_storeu_ps, EXPR, SCALAR)
+
+        AVX512_KERNEL(Inverse, _mm512_div_pd(_mm512_set1_pd(1), a), Scalar::inverse)
+        AVX512_KERNEL(Negative, _mm512_mul_pd(_mm512_set1_pd(-1), a), Scalar::negative)
+        AVX512_KERNEL(Add, _mm512_add_pd(a, b), Scalar::add)
+        AVX512_KERNEL(Subtract, _mm512_sub_pd(a, b), Scalar::subtract)
+        AVX512_KERNEL(Multiply, _mm512_mul_pd(a, b), Scalar::multiply)
+        AVX512_KERNEL(Divide, _mm512_maskz_div_pd(_mm512_cmp_pd_mask(b, _mm512_setzero_pd(), _CMP_NEQ_UQ), a, b), Scalar::divide) // masked lanes (y == 0) become 0
+        AVX512_KERNEL(Abs, _mm512_abs_pd(a), Scalar::abs)
+
+        AVX512_KERNEL_F(InverseF, _mm512_div_ps(_mm512_set1_ps(1), a), Scalar::inverse)
+        AVX512_KERNEL_F(NegativeF, _mm512_mul_ps(_mm512_set1_ps(-1), a), Scalar::negative)
+        AVX512_KERNEL_F(AddF, _mm512_add_ps(a, b), Scalar::add)
+        AVX512_KERNEL_F(SubtractF, _mm512_sub_ps(a, b), Scalar::subtract)
+        AVX512_KERNEL_F(MultiplyF, _mm512_mul_ps(a, b), Scalar::multiply)
+        AVX512_KERNEL_F(DivideF, _mm512_maskz_div_ps(_mm512_cmp_ps_mask(b, _mm512_setzero_ps(), _CMP_NEQ_UQ), a, b), Scalar::divide)
+        AVX512_KERNEL_F(AbsF, _mm512_abs_ps(a), Scalar::abs)
+
+        static const KernelTable<double> table {Inverse, Negative, Add, Subtract, Multiply, Divide, Loop::Power<double>, Abs, Loop::Sin<double>, Loop::Cos<double>, Loop::Tan<double>};
+        static const KernelTable<float> tableF {InverseF, NegativeF, AddF, SubtractF, MultiplyF, DivideF, Loop::Power<float>, AbsF, Loop::Sin<float>, Loop::Cos<float>, Loop::Tan<float>};
+    }
+
+#endif // BATCH_X86
+
+    static BatchLevel supportedLevel() {
+#ifdef BATCH_X86
+        __builtin_cpu_init();
+        if(__builtin_cpu_supports("avx512f")) return BATCH_AVX512;
+        if(__builtin_cpu_supports("avx2")) return BATCH_AVX2;
+        if(__builtin_cpu_supports("sse2")) return BATCH_SSE2;
+#endif
+        return BATCH_SCALAR;
+    }
+
+    static const BatchLevel maxLevel = supportedLevel();
+    static std::atomic<BatchLevel> currentLevel(maxLevel);
+
+    BatchLevel batchLevel() {
+        return currentLevel;
+    }
+
+    BatchLevel setBatchLevel(BatchLevel level) {
+        currentLevel = std::min(level, maxLevel);
+        return currentLevel;
+    }
+
+    const char* batchLevelName(BatchLevel level) {
+        switch(level){
+            case BATCH_SSE2: return "SSE2";
+            case BATCH_AVX2: return "AVX2";
+            case BATCH_AVX512: return "AVX-512";
+            default: return "scalar";
+        }
+    }
+
+    template<typename T>
+    static basic_batchfunc<T> lookup(const KernelTable<T>& table, func function) {
+        if(function == &Inverse) return table.inverse;
+        if(function == &Negative) return table.negative;
+        if(function == &Add) return table.add;
+        if(function == &Subtract) return table.subtract;
+        if(function == &Multiply) return table.multiply;
+        if(function == &Divide) return table.divide;
+        if(function == &Power) return table.power;
+        if(function == &Abs) return table.abs;
+        if(function == &Sin) return table.sin;
+        if(function == &Cos) return table.cos;
+        if(function == &Tan) return table.tan;
+        return nullptr; // unknown operator - caller must fall back to the scalar function
+    }
+
+    template<>
+    basic_batchfunc<double> vectorize<double>(func function) {
+#ifdef BATCH_X86
+        switch(currentLevel.load()){
+            case BATCH_AVX512: return lookup(AVX512::table, function);
+            case BATCH_AVX2: return lookup(AVX2::table, function);
+            case BATCH_SSE2: return lookup(SSE2::table, function);
+            default: break;
+        }
+#endif
+        return lookup(Loop::table<double>, function);
+    }
+
+    template<>
+    basic_batchfunc<float> vectorize<float>(func function) {
+#ifdef BATCH_X86
+        switch(currentLevel.load()){
+            case BATCH_AVX512: return lookup(AVX512::tableF, function);
+            case BATCH_AVX2: return lookup(AVX2::tableF, function);
+            case BATCH_SSE2: return lookup(SSE2::tableF, function);
+            default: break;
+        }
+#endif
+        return lookup(Loop::table<float>, function);
+    }
+
+}
@@ -0,0 +1,542 @@
+#include "benchmark.h"
+#include "evorootnode.h"
+#include "program.h"
+#include "clock.h"
+#include "evoalgo.h"
+#include "flattree.h"
+#include "threadpool.h"
+#include "formset.h"
+
+#include <map>
+#include <random>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Benchmark {
+
+    typedef void (*Bench)(Parameters* params, const Operators::EqPoints& data);
+
+    static const std::map<std::string, Bench> benchmarks = {
+        {"threads", &threads},
+        {"arena", &arena},
+        {"trees", &trees},
+        {"traversal", &traversal},
+        {"dispatch", &dispatch},
+        {"selection", &selection},
+        {"duplicates", &duplicates},
+        {"kernels", &kernels},
+        {"jit", &jit}
+    };
+
+    bool run(const std::string& name, Parameters* params, const Operators::EqPoints& data) {
+        auto itt = benchmarks.find(name);
+        if(itt == benchmarks.end()){
+            std::string list;
+            for(auto& b : benchmarks) list += " " + b.first;
+            warning("unknown benchmark \"" + name + "\" - available benchmarks:" + list);
+            return false;
+        }
+        RootNode::params = params;
+        syslog::cout << "---------- Benchmark: " << name << " (" << data.size() << " points) ----------\n";
+        itt->second(params, data);
+        return true;
+    }
+
+    // random trees shaped like the initial population
+    static std::vector<RootNode*> randomTrees(size_t count, int mutations) {
+        std::vector<RootNode*> trees;
+        for(size_t i=0; i < count; ++i){
+            RootNode* rt = new RootNode;
+            rt->node = rt->createNode(NodeTypes::RANDOM_OP, true);
+            rt->node = rt->mutateAdd(mutations);
+            trees.push_back(rt);
+        }
+        return trees;
+    }
+
+    void threads(Parameters* params, const Operators::EqPoints& data) {
+        params->visual.display = false;
+        EvoAlgo evo(params, data);
+        uint32_t cutoff = std::round(params->popSize * params->survivalRatio);
+        const size_t children = evo.population.size() - cutoff;
+        const int repeat = 5;
+
+        syslog::cout << children << " children from " << cutoff << " survivors - " << std::thread::hardware_concurrency() << " hardware threads\n";
+        double single = 0;
+        for(size_t n = 1; n <= 64; n *= 2){
+            evo.threadCount = n;
+            Clock timer;
+            for(int r=0; r < repeat; ++r) evo.threadGenerator(cutoff, evo.population.size(), &EvoAlgo::workRepopulate, &cutoff);
+            const double time = timer.getMilliseconds();
+            if(n == 1) single = time;
+
+            syslog::cout << "threads " << n << ": " << (time / repeat) << "ms per repopulation  " << size_t(children * repeat / (time / 1000.0)) << " children/s  ("
+                         << (single / time) << "x)\n";
+        }
+    }
+
+    void arena(Parameters* params, const Operators::EqPoints& data) {
+        params->visual.display = false;
+        EvoAlgo evo(params, data);
+        uint32_t cutoff = std::round(params->popSize * params->survivalRatio);
+        const size_t children = evo.population.size() - cutoff;
+        const int repeat = 10;
+        evo.threadCount = 1;
+
+        double freeTime = 0;
+        for(bool reset : {false, true, false, true}){ // interleaved so both modes see the same tree sizes
+            params->useArenaReset = reset;
+            Clock timer;
+            for(int r=0; r < repeat; ++r) evo.threadGenerator(cutoff, evo.population.size(), &EvoAlgo::workRepopulate, &cutoff);
+            const double time = timer.getMilliseconds();
+            if(!reset) freeTime = time;
+
+            syslog::cout << (reset ? "arena reset: " : "node frees:  ") << (time / repeat) << "ms per repopulation  " << size_t(children * repeat / (time / 1000.0)) << " children/s"
+                         << (reset ? "  (" + std::to_string(freeTime / time) + "x)" : std::string()) << "\n";
+        }
+        if(!evo.checkForMemoryConsistency()) warning("node pools are inconsistent after the arena resets");
+    }
+
+    void trees(Parameters*, const Operators::EqPoints&) { // synthetic trees - the loaded points are not used
+        const size_t count = 500;
+        const int repeat = 20;
+        for(int mutations : {3, 10, 30, 100}){
+            std::vector<RootNode*> trees = randomTrees(count, mutations);
+            std::vector<FlatTree> flats;
+            std::vector<std::vector<Node*>> lists(count);
+            size_t nodes = 0;
+            for(size_t i=0; i < count; ++i){
+                flats.emplace_back(trees[i]->node);
+                trees[i]->node->collect(lists[i]); // preorder - list index i is flat slot i
+                nodes += lists[i].size();
+            }
+
+            // copy: the pool copy also has to give its nodes back, the flat copy reuses its buffer
+            RootNode target;
+            Clock timer;
+            for(int r=0; r < repeat; ++r){
+                for(RootNode* rt : trees){
+                    target.node = rt->node->copy(&target);
+                    target.node->freeAll();
+                }
+            }
+            const double nodeCopy = timer.getMilliseconds();
+
+            FlatTree flatTarget;
+            timer.restart();
+            for(int r=0; r < repeat; ++r)
+                for(const FlatTree& f : flats) flatTarget = f;
+            const double flatCopy = timer.getMilliseconds();
+
+            // crossover: the same parents and crossover points for both stores
+            std::vector<std::array<size_t, 4>> picks(count * repeat);
+            for(auto& p : picks){
+                p[0] = Random::randomInt(count - 1);
+                p[1] = Random::randomInt(lists[p[0]].size() - 1);
+                p[2] = Random::randomInt(count - 1);
+                p[3] = Random::randomInt(lists[p[2]].size() - 1);
+            }
+            timer.restart();
+            for(const auto& p : picks){
+                target.node = trees[p[0]]->node->copyMutate(&target, lists[p[0]][p[1]], lists[p[2]][p[3]]);
+                target.node->freeAll();
+            }
+            const double nodeCross = timer.getMilliseconds();
+
+            timer.restart();
+            for(const auto& p : picks) flatTarget.crossover(flats[p[0]], p[1], flats[p[2]], p[3]);
+            const double flatCross = timer.getMilliseconds();
+
+            size_t mismatch = 0;
+            for(size_t k=0; k < count; ++k){ // both stores must produce the same trees
+                const auto& p = picks[k];
+                target.node = trees[p[0]]->node->copyMutate(&target, lists[p[0]][p[1]], lists[p[2]][p[3]]);
+                flatTarget.crossover(flats[p[0]], p[1], flats[p[2]], p[3]);
+                Node* rebuilt = flatTarget.build(&target);
+                if(target.node->string() != flatTarget.string() || rebuilt->string() != flatTarget.string()) ++mismatch;
+                rebuilt->freeAll();
+                target.node->freeAll();
+            }
+            target.node = nullptr;
+
+            const double copies = double(count * repeat);
+            syslog::cout << "mutations " << mutations << ": " << (double(nodes) / count) << " nodes per tree\n"
+                         << "    copy       nodes: " << size_t(copies / (nodeCopy / 1000.0)) << " trees/s  flat: " << size_t(copies / (flatCopy / 1000.0)) << " trees/s  (" << (nodeCopy / flatCopy) << "x)\n"
+                         << "    crossover  nodes: " << size_t(copies / (nodeCross / 1000.0)) << " trees/s  flat: " << size_t(copies / (flatCross / 1000.0)) << " trees/s  (" << (nodeCross / flatCross) << "x)\n"
+                         << "    mismatched trees: " << mismatch << "\n";
+
+            for(RootNode* rt : trees) delete rt;
+        }
+    }
+
+    // the per-call node lists the traversals replaced - a fresh list of every kind, merged per node
+    struct KindLists {
+        std::vector<Node*> operators, variables, constants, all;
+
+        KindLists& operator+=(const KindLists& rs) {
+            for(Node* n : rs.constants) constants.push_back(n);
+            for(Node* n : rs.operators) operators.push_back(n);
+            for(Node* n : rs.variables) variables.push_back(n);
+            for(Node* n : rs.all) all.push_back(n);
+            return *this;
+        }
+    };
+
+    static void kindLists(Node* n, KindLists& lists) {
+        if(!n->isOperator()){
+            lists += (n->name == NodeTypes::CONSTANT ? KindLists {{}, {}, {n}, {n}} : KindLists {{}, {n}, {}, {n}});
+            return;
+        }
+        lists += KindLists {{n}, {}, {}, {n}};
+        for(int i=0; i < n->arity; ++i) kindLists(n->child(i), lists);
+    }
+
+    void traversal(Parameters*, const Operators::EqPoints&) { // synthetic trees - the loaded points are not used
+        const size_t count = 500;
+        const int repeat = 20;
+        for(int mutations : {3, 10, 30, 100}){
+            std::vector<RootNode*> trees = randomTrees(count, mutations);
+            size_t picked[3] = {0, 0, 0}; // checksums so the three walks cannot be optimized away and must agree
+
+            Clock timer;
+            for(int r=0; r < repeat; ++r){
+                for(RootNode* rt : trees){
+                    KindLists lists; kindLists(rt->node, lists);
+                    picked[0] += lists.all.size() + lists.operators.size();
+                }
+            }
+            const double listTime = timer.getMilliseconds();
+
+            timer.restart();
+            for(int r=0; r < repeat; ++r){
+                for(RootNode* rt : trees){
+                    NodeBuffer nodes; rt->node->collect(*nodes);
+                    NodeBuffer operators; rt->node->collect(*operators, Node::KIND_OPERATOR);
+                    picked[1] += nodes->size() + operators->size();
+                }
+            }
+            const double collectTime = timer.getMilliseconds();
+
+            timer.restart();
+            for(int r=0; r < repeat; ++r){
+                for(RootNode* rt : trees){
+                    picked[2] += rt->node->count() + rt->node->count(Node::KIND_OPERATOR);
+                }
+            }
+            const double cursorTime = timer.getMilliseconds();
+
+            const double walks = double(count * repeat);
+            syslog::cout << "mutations " << mutations << ": " << (double(picked[1]) / walks) << " nodes + operators per tree\n"
+                         << "    node lists: " << size_t(walks / (listTime / 1000.0)) << " trees/s  collect: " << size_t(walks / (collectTime / 1000.0)) << " trees/s  ("
+                         << (listTime / collectTime) << "x)  cursor: " << size_t(walks / (cursorTime / 1000.0)) << " trees/s  (" << (listTime / cursorTime) << "x)\n";
+            if(picked[0] != picked[1] || picked[1] != picked[2]) warning("traversals visited different nodes");
+
+            for(RootNode* rt : trees) delete rt;
+        }
+    }
+
+    void dispatch(Parameters*, const Operators::EqPoints&) { // empty phases - the loaded points are not used
+        const int phases = 2000;
+        std::atomic<size_t> sum(0);
+        auto work = [&](size_t t){ sum += t + 1; }; // next to nothing - only the cost of handing out a phase is measured
+
+        ThreadPool pool;
+        for(size_t n : {size_t(1), size_t(2), size_t(4), size_t(8), size_t(std::max(1u, std::thread::hardware_concurrency()))}){
+            Clock timer;
+            for(int p=0; p < phases; ++p){ // a fresh thread per worker and phase
+                std::vector<std::thread> threads;
+                for(size_t t=0; t < n; ++t) threads.emplace_back(work, t);
+                for(std::thread& t : threads) t.join();
+            }
+            const double spawnTime = timer.getMilliseconds();
+
+            timer.restart();
+            for(int p=0; p < phases; ++p) pool.run(n, work);
+            const double poolTime = timer.getMilliseconds();
+
+            syslog::cout << "workers " << n << ": spawn + join " << (spawnTime * 1000 / phases) << "us per phase  pool " << (poolTime * 1000 / phases)
+                         << "us per phase  (" << (spawnTime / poolTime) << "x)\n";
+        }
+        if(sum == 0) warning("dispatch benchmark did not run");
+    }
+
+    void selection(Parameters* params, const Operators::EqPoints& data) {
+        params->visual.display = false;
+        const size_t popSize = params->popSize;
+        params->popSize = 100; // the engine only lends its sort - the populations below are plain scored roots
+        EvoAlgo evo(params, data);
+        EvoAlgo::Population own;
+        own.swap(evo.population);
+        std::mt19937 shuffler(42);
+
+        for(size_t count : {size_t(4000), size_t(100000), size_t(1000000)}){
+            params->popSize = count;
+            const int repeat = std::max(1, int(4000000 / count));
+            std::vector<float> scores(count);
+            for(float& s : scores) s = float(Random::random() * 100);
+            for(size_t i=0; i < count; ++i){
+                evo.population.push_back(new RootNode);
+                evo.population.back()->rejected = Random::chance(10); // like early abort
+            }
+            std::shuffle(evo.population.begin(), evo.population.end(), shuffler); // the roots of a real population are scattered over the heap
+
+            auto rescore = [&](){ for(size_t i=0; i < count; ++i) evo.population[i]->score = scores[i]; }; // the same unsorted scores for every pass
+            double sortTime = 0, selectTime = 0;
+            for(int r=0; r < repeat; ++r){
+                for(int pass=0; pass < 3; ++pass){ // the sorts of one generation
+                    rescore();
+                    Clock timer;
+                    std::sort(evo.population.begin(), evo.population.end(), [](RootNode* l, RootNode* r) {
+                        if(l->rejected != r->rejected) return r->rejected;
+                        return (l->score < r->score);
+                    });
+                    sortTime += timer.getMilliseconds();
+                }
+                for(int pass=0; pass < 3; ++pass){
+                    rescore();
+                    Clock timer;
+                    evo.sortPopulation(evo.selectionSize(count));
+                    selectTime += timer.getMilliseconds();
+                }
+            }
+
+            syslog::cout << "population " << count << ": full sorts " << (sortTime / repeat) << "ms per generation  selection of " << evo.selectionSize(count) << " ranks "
+                         << (selectTime / repeat) << "ms per generation  (" << (sortTime / selectTime) << "x)\n";
+            for(RootNode* rt : evo.population) delete rt;
+            evo.population.clear();
+        }
+
+        evo.population.swap(own);
+        params->popSize = popSize;
+    }
+
+    void duplicates(Parameters*, const Operators::EqPoints&) { // synthetic trees - the loaded points are not used
+        for(size_t count : {size_t(1000), size_t(4000), size_t(16000)}){
+            std::vector<RootNode*> trees = randomTrees(count, 2); // small trees - plenty of duplicates like a converging population
+            for(RootNode* rt : trees) rt->calculateForm();
+
+            Clock timer;
+            size_t pairwise = 0;
+            for(size_t i=0; i < count; ++i){ // the old scan - every form against all later ones
+                const std::string& form = trees[i]->form;
+                if(std::find_if(trees.begin() + i + 1, trees.end(), [&](const RootNode* o){ return o->form == form; }) != trees.end()) ++pairwise;
+            }
+            const double pairTime = timer.getMilliseconds();
+
+            FormSet set;
+            size_t hashed = 0;
+            timer.restart();
+            set.reset(count);
+            for(RootNode* rt : trees){
+                rt->formHash = FormSet::hash(rt->form);
+                if(!set.insert(rt->formHash)) ++hashed;
+            }
+            const double hashTime = timer.getMilliseconds();
+
+            syslog::cout << "population " << count << ": pairwise " << pairTime << "ms  form hashes " << hashTime << "ms  (" << (pairTime / hashTime) << "x)  "
+                         << hashed << " duplicates" << (hashed == pairwise ? "" : " - the pairwise scan found " + std::to_string(pairwise)) << "\n";
+            for(RootNode* rt : trees) delete rt;
+        }
+    }
+
+    // times every batch kernel of one instruction set on the same columns - the scalar level is the plain loop
+    template<typename T>
+    static void kernelLevels(const char* type, const Operators::BasicColumn<T>& x, const Operators::BasicColumn<T>& y, size_t repeat) {
+        static const std::vector<std::pair<const char*, Operators::func>> operators = {
+            {"inverse", &Operators::Inverse}, {"negative", &Operators::Negative}, {"add", &Operators::Add}, {"subtract", &Operators::Subtract},
+            {"multiply", &Operators::Multiply}, {"divide", &Operators::Divide}, {"power", &Operators::Power}, {"abs", &Operators::Abs},
+            {"sin", &Operators::Sin}, {"cos", &Operators::Cos}, {"tan", &Operators::Tan}
+        };
+        const Operators::BatchLevel best = Operators::batchLevel();
+        const size_t len = x.size();
+        Operators::BasicColumn<T> reference(len), out(len);
+
+        syslog::cout << type << " (" << len << " rows x " << repeat << ")\n";
+        for(const auto& op : operators){
+            Operators::setBatchLevel(Operators::BATCH_SCALAR);
+            Operators::basic_batchfunc<T> scalar = Operators::vectorize<T>(op.second);
+            Clock timer;
+            for(size_t r=0; r < repeat; ++r) scalar(x.data(), y.data(), reference.data(), len);
+            const double scalarTime = timer.getMilliseconds();
+
+            syslog::cout << "    " << op.first << ": scalar " << scalarTime << "ms";
+            for(Operators::BatchLevel level : {Operators::BATCH_SSE2, Operators::BATCH_AVX2, Operators::BATCH_AVX512}){
+                if(level > best) break;
+                Operators::setBatchLevel(level);
+                Operators::basic_batchfunc<T> kernel = Operators::vectorize<T>(op.second);
+                timer.restart();
+                for(size_t r=0; r < repeat; ++r) kernel(x.data(), y.data(), out.data(), len);
+                const double levelTime = timer.getMilliseconds();
+
+                size_t mismatch = 0;
+                for(size_t i=0; i < len; ++i){
+                    if(out[i] != reference[i] && !(std::isnan(out[i]) && std::isnan(reference[i]))) ++mismatch;
+                }
+                syslog::cout << "  " << Operators::batchLevelName(level) << " " << levelTime << "ms (" << (scalarTime / levelTime) << "x)";
+                if(mismatch > 0) syslog::cout << " " << mismatch << " mismatched";
+            }
+            syslog::cout << "\n";
+        }
+        Operators::setBatchLevel(best);
+    }
+
+    void kernels(Parameters*, const Operators::EqPoints& data) {
+        const size_t len = 4096; // one evaluation block that stays in L1/L2
+        const size_t repeat = 2000;
+        Operators::Column x(len), y(len);
+        for(size_t i=0; i < len; ++i){ // the loaded points where there are any - the divide kernels also see y == 0
+            x[i] = (data.numVars > 0 && !data.empty() ? data.columns[0][i % data.size()] : Random::random() * 20 - 10);
+            y[i] = (i % 64 == 0 ? 0 : (!data.empty() ? data.results[i % data.size()] : Random::random() * 4 - 2));
+        }
+        Operators::BasicColumn<float> xf(x.begin(), x.end()), yf(y.begin(), y.end());
+
+        syslog::cout << "best instruction set on this CPU: " << Operators::batchLevelName(Operators::batchLevel()) << "\n";
+        kernelLevels<VTYPE>("double", x, y, repeat);
+        kernelLevels<float>("float", xf, yf, repeat);
+    }
+
+#if defined(__x86_64__) && defined(__linux__)
+    /*  NativeProgram: a minimal x86-64 emitter to measure a JIT for elite individuals against the interpreter
+
+         A compiled Program becomes one native loop over the rows - every instruction computes one
+         point into its slot on the stack. add, subtract and multiply are inlined as SSE2 scalar
+         instructions, every other operator calls the same operator function the interpreter uses.
+            void run(const double* const* columns, const double* constants, double* out, size_t rows)
+    */
+    class NativeProgram {
+    public:
+        typedef void (*Function)(const double* const* columns, const double* constants, double* out, size_t rows);
+
+        NativeProgram(const Program& program, int numVars): memory(nullptr), size(0), run(nullptr) {
+            std::vector<uint8_t> c;
+            auto bytes = [&](std::initializer_list<uint8_t> b){ c.insert(c.end(), b); };
+            auto imm32 = [&](uint32_t v){ for(int i=0; i < 4; ++i) c.push_back(uint8_t(v >> (8 * i))); };
+            auto slot = [&](uint8_t opcode, uint8_t reg, uint16_t s){ bytes({0xF2, 0x0F, opcode, uint8_t(0x84 | reg << 3), 0x24}); imm32(8u * s); }; // <op>sd xmm<reg>, [rsp + 8 * s]
+
+            const uint32_t frame = (8u * program.numSlots + 15) / 16 * 16 + 8; // rsp is 16 byte aligned at every call
+            bytes({0x55, 0x53, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbp, rbx, r12-r15
+            bytes({0x49, 0x89, 0xFC, 0x49, 0x89, 0xF5, 0x49, 0x89, 0xD6, 0x49, 0x89, 0xCF}); // r12 = columns, r13 = constants, r14 = out, r15 = rows
+            bytes({0x48, 0x81, 0xEC}); imm32(frame); // sub rsp, frame
+            bytes({0x31, 0xDB, 0x4D, 0x85, 0xFF, 0x0F, 0x84}); // rbx = 0 - no rows: jz end
+            const size_t skip = c.size(); imm32(0);
+            const size_t loop = c.size();
+
+            for(const Program::Instruction& ins : program.code){
+                if(ins.arity == 0){
+                    if(ins.op == NodeTypes::CONSTANT){
+                        bytes({0xF2, 0x41, 0x0F, 0x10, 0x85}); imm32(8u * ins.index); // movsd xmm0, [r13 + 8 * index]
+                    } else if(ins.op != Program::COLUMN && ins.index < uint32_t(numVars)){
+                        bytes({0x49, 0x8B, 0x84, 0x24}); imm32(8u * ins.index); // mov rax, [r12 + 8 * index]
+                        bytes({0xF2, 0x0F, 0x10, 0x04, 0xD8}); // movsd xmm0, [rax + rbx * 8]
+                    } else {
+                        bytes({0x66, 0x0F, 0x57, 0xC0}); // xorpd xmm0, xmm0
+                    }
+                } else if(ins.arity == 2 && (ins.op == NodeTypes::ADD || ins.op == NodeTypes::SUBTRACT || ins.op == NodeTypes::MULTIPLY)){
+                    slot(0x10, 0, ins.a);
+                    slot(ins.op == NodeTypes::ADD ? 0x58 : ins.op == NodeTypes::SUBTRACT ? 0x5C : 0x59, 0, ins.b); // addsd / subsd / mulsd xmm0, [b]
+                } else {
+                    slot(0x10, 0, ins.a);
+                    if(ins.arity == 2) slot(0x10, 1, ins.b);
+                    else bytes({0x66, 0x0F, 0x57, 0xC9}); // xorpd xmm1, xmm1 - like the interpreter's unary fallback
+                    bytes({0x48, 0xB8}); // mov rax, function
+                    const uint64_t f = reinterpret_cast<uint64_t>(ins.function);
+                    for(int i=0; i < 8; ++i) c.push_back(uint8_t(f >> (8 * i)));
+                    bytes({0xFF, 0xD0}); // call rax
+                }
+                slot(0x11, 0, ins.dst); // movsd [dst], xmm0
+            }
+
+            slot(0x10, 0, 0); // slot 0 holds the root result
+            bytes({0xF2, 0x41, 0x0F, 0x11, 0x04, 0xDE}); // movsd [r14 + rbx * 8], xmm0
+            bytes({0x48, 0xFF, 0xC3, 0x4C, 0x39, 0xFB, 0x0F, 0x82}); // rbx++ - cmp rbx, r15 - jb loop
+            imm32(uint32_t(loop - (c.size() + 4)));
+            const uint32_t end = uint32_t(c.size() - (skip + 4));
+            std::memcpy(&c[skip], &end, 4);
+            bytes({0x48, 0x81, 0xC4}); imm32(frame); // add rsp, frame
+            bytes({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5B, 0x5D, 0xC3}); // pop r15-r12, rbx, rbp - ret
+
+            size = c.size();
+            void* m = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(m == MAP_FAILED) return;
+            std::memcpy(m, c.data(), size);
+            if(mprotect(m, size, PROT_READ | PROT_EXEC) != 0){
+                munmap(m, size);
+                return;
+            }
+            memory = m;
+            run = reinterpret_cast<Function>(m);
+        }
+        ~NativeProgram() { if(memory != nullptr) munmap(memory, size); }
+        NativeProgram(const NativeProgram&) = delete;
+        NativeProgram& operator=(const NativeProgram&) = delete;
+
+        void* memory;
+        size_t size;
+        Function run; // nullptr when no executable memory could be mapped
+    };
+#endif
+
+    void jit(Parameters*, const Operators::EqPoints& data) {
+#if defined(__x86_64__) && defined(__linux__)
+        if(data.empty()){
+            warning("the jit benchmark needs point data");
+            return;
+        }
+        const size_t count = 200;
+        const int repeat = 5;
+        std::vector<const VTYPE*> columns(data.numVars);
+        for(int v=0; v < data.numVars; ++v) columns[v] = data.columns[v].data();
+        Operators::Column interpreted(data.size()), native(data.size());
+
+        syslog::cout << count << " random trees per size - interpreter at " << Operators::batchLevelName(Operators::batchLevel()) << " vs one native loop per tree\n";
+        for(int mutations : {3, 10, 30}){
+            std::vector<RootNode*> trees = randomTrees(count, mutations);
+            std::vector<Program> programs;
+            std::vector<std::unique_ptr<NativeProgram>> natives;
+            size_t instructions = 0, mismatch = 0;
+            for(RootNode* rt : trees){
+                programs.emplace_back(rt->node);
+                natives.emplace_back(new NativeProgram(programs.back(), data.numVars));
+                if(natives.back()->run == nullptr){
+                    warning("could not map executable memory for the native programs");
+                    for(RootNode* t : trees) delete t;
+                    return;
+                }
+                instructions += programs.back().code.size();
+            }
+
+            Clock timer;
+            for(int r=0; r < repeat; ++r){
+                for(const Program& program : programs) program.computeBlock(data, 0, data.size(), interpreted.data());
+            }
+            const double interpreterTime = timer.getMilliseconds();
+
+            timer.restart();
+            for(int r=0; r < repeat; ++r){
+                for(size_t t=0; t < natives.size(); ++t) natives[t]->run(columns.data(), programs[t].constants.data(), native.data(), data.size());
+            }
+            const double nativeTime = timer.getMilliseconds();
+
+            for(size_t t=0; t < trees.size(); ++t){ // both must compute the same values
+                programs[t].computeBlock(data, 0, data.size(), interpreted.data());
+                natives[t]->run(columns.data(), programs[t].constants.data(), native.data(), data.size());
+                for(size_t i=0; i < data.size(); ++i){
+                    if(interpreted[i] != native[i] && !(std::isnan(interpreted[i]) && std::isnan(native[i]))) ++mismatch;
+                }
+            }
+
+            syslog::cout << "mutations " << mutations << " (" << (double(instructions) / count) << " instructions): interpreter " << interpreterTime << "ms  native "
+                         << nativeTime << "ms (" << (interpreterTime / nativeTime) << "x)";
+            if(mismatch > 0) syslog::cout << " " << mismatch << " mismatched";
+            syslog::cout << "\n";
+            for(RootNode* rt : trees) delete rt;
+        }
+#else
+        warning("the jit benchmark emits x86-64 code and only runs on x86-64 Linux");
+#endif
+    }
+
+}
@@ -3,7 +3,6 @@
 
 
 size_t calculatePoolSize() {
-    return (sizeof(RootNode) + sizeof(NodePool) + sizeof(std::mutex) + sizeof(NodePool::Pool)) * 1.3f;
-    // for now we will add a 130% boost for deterministic accuracy because the
-    // current value seems to be off by being 30% less than the actual memory allocated
-}
\ No newline at end of file
+    RootNode rt; // measured on a real root - the first sub-pool is allocated by the constructor
+    return sizeof(RootNode) + rt.pool.memoryUsage();
+}
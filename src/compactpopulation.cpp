@@ -0,0 +1,138 @@
+#include "compactpopulation.h"
+#include "node.h"
+
+#include <cstring>
+#include <cmath>
+
+using namespace NodeTypes;
+
+namespace {
+    constexpr uint8_t NAME_MASK = 0x0F;
+    constexpr uint8_t SHORT_CONSTANT = 1; // payload of a constant stored as k / scale
+    constexpr size_t INLINE_VARIABLES = 15; // variables below this index are stored in the payload
+
+    inline void writeVarint(std::vector<uint8_t>& out, uint64_t v) {
+        while(v >= 0x80){
+            out.push_back(uint8_t(v) | 0x80);
+            v >>= 7;
+        }
+        out.push_back(uint8_t(v));
+    }
+
+    inline uint64_t readVarint(const uint8_t*& data) {
+        uint64_t v = 0;
+        for(int shift = 0;; shift += 7){
+            const uint8_t b = *data++;
+            v |= uint64_t(b & 0x7F) << shift;
+            if(!(b & 0x80)) return v;
+        }
+    }
+}
+
+static_assert(NodeTypes::TAN <= NAME_MASK, "node names must fit in the low nibble of the encoding");
+
+CompactPopulation::CompactPopulation(VTYPE scale): scale(scale) {}
+
+void CompactPopulation::encode(const Node* root, std::vector<uint8_t>& out, VTYPE scale) {
+    for(NodeCursor cursor(root); Node* n = cursor.next();){
+        if(n->name == VARIABLE){
+            const size_t index = size_t(static_cast<VarNode*>(n)->value.val);
+            if(index < INLINE_VARIABLES){
+                out.push_back(VARIABLE | uint8_t((index + 1) << 4));
+            } else {
+                out.push_back(VARIABLE);
+                writeVarint(out, index);
+            }
+        } else if(n->name == CONSTANT){
+            const VTYPE value = static_cast<VarNode*>(n)->value.val,
+                        k = std::round(value * scale);
+            if(std::abs(k) < VTYPE(1ll << 53) && k / scale == value && !(value == 0 && std::signbit(value))){ // exact round trip only
+                const int64_t i = int64_t(k);
+                out.push_back(CONSTANT | (SHORT_CONSTANT << 4));
+                writeVarint(out, (uint64_t(i) << 1) ^ uint64_t(i >> 63)); // zigzag - small negative constants stay short
+            } else {
+                out.push_back(CONSTANT);
+                const size_t at = out.size();
+                out.resize(at + sizeof(VTYPE));
+                std::memcpy(out.data() + at, &value, sizeof(VTYPE));
+            }
+        } else {
+            out.push_back(n->name);
+        }
+    }
+}
+
+Node* CompactPopulation::decode(const uint8_t*& data, RootNode& root, VTYPE scale) {
+    const uint8_t code = *data++,
+                  payload = code >> 4;
+    const FunctionName name = FunctionName(code & NAME_MASK);
+
+    if(name == VARIABLE){
+        const size_t index = (payload ? payload - 1 : readVarint(data));
+        return root.allocateVarNode(VARIABLE, Value(VTYPE(index)), false);
+    }
+    if(name == CONSTANT){
+        VTYPE value;
+        if(payload == SHORT_CONSTANT){
+            const uint64_t z = readVarint(data);
+            value = VTYPE(int64_t(z >> 1) ^ -int64_t(z & 1)) / scale;
+        } else {
+            std::memcpy(&value, data, sizeof(VTYPE));
+            data += sizeof(VTYPE);
+        }
+        return root.allocateVarNode(CONSTANT, Value(value), false);
+    }
+
+    Node* node = root.allocateOpNode(name, {nullptr, nullptr}, false);
+    for(int c=0; c < node->arity; ++c) node->setchild(c, decode(data, root, scale));
+    return node;
+}
+
+void CompactPopulation::begin(size_t count, size_t writers) {
+    next.assign(count, Individual {0, 0, 0, false, INFINITY, 0});
+    if(chunks.size() < writers) chunks.resize(writers);
+    for(std::vector<uint8_t>& c : chunks) c.clear(); // capacity is kept for the next generation
+}
+
+CompactPopulation::Individual& CompactPopulation::write(size_t writer, size_t index, const Node* root) {
+    std::vector<uint8_t>& chunk = chunks[writer];
+    Individual& ind = next[index];
+    ind.offset = chunk.size();
+    ind.chunk = uint16_t(writer);
+    encode(root, chunk, scale);
+    ind.size = uint32_t(chunk.size() - ind.offset);
+    return ind;
+}
+
+void CompactPopulation::commit() {
+    std::vector<uint64_t> base(chunks.size());
+    size_t total = 0;
+    for(size_t c=0; c < chunks.size(); ++c){
+        base[c] = total;
+        total += chunks[c].size();
+    }
+
+    spare.resize(total);
+    for(size_t c=0; c < chunks.size(); ++c){
+        if(!chunks[c].empty()) std::memcpy(spare.data() + base[c], chunks[c].data(), chunks[c].size());
+    }
+    for(Individual& ind : next) ind.offset += base[ind.chunk];
+
+    buffer.swap(spare);
+    individuals.swap(next);
+}
+
+Node* CompactPopulation::decode(size_t index, RootNode& root) const {
+    root.reset();
+    const uint8_t* data = buffer.data() + individuals[index].offset;
+    root.node = decode(data, root, scale);
+    root.node->setParent(nullptr);
+    return root.node;
+}
+
+size_t CompactPopulation::memoryUsage() const {
+    size_t bytes = buffer.capacity() + spare.capacity() + (individuals.capacity() + next.capacity()) * sizeof(Individual)
+                 + chunks.capacity() * sizeof(std::vector<uint8_t>);
+    for(const std::vector<uint8_t>& c : chunks) bytes += c.capacity();
+    return bytes;
+}
@@ -26,15 +26,17 @@ bool CSVLoader::load(Operators::EqPoints& points) {
     file.close(); // close file when finished
     
     size_t pos = 0, row = 0;
-    std::vector<std::vector<VTYPE>> inpoints;
-    inpoints.resize(1, {});
+    std::vector<VTYPE> values; // every parsed value in row order
+    std::vector<size_t> rowLength; // number of values found on each row
+    rowLength.resize(1, 0);
     std::string part;
 
     auto addPart = [&]() -> bool {
         if(!part.empty()){
             try {
                 double val = std::stod(part);
-                inpoints[row].push_back(val);
+                values.push_back(val);
+                rowLength[row]++;
             } catch (std::invalid_argument e) {
                 syslog::cout << "invalid_argument error: " << part << " at position " << pos << "\n";
                 return false;
@@ -61,7 +63,7 @@ bool CSVLoader::load(Operators::EqPoints& points) {
                 if(part.empty()) continue;
 
                 if(!addPart()) return false;
-                inpoints.push_back({});
+                rowLength.push_back(0);
                 row++;
                 continue;
             }
@@ -76,30 +78,32 @@ bool CSVLoader::load(Operators::EqPoints& points) {
     if(!part.empty()) { // get last part in case no line or comma was added
         if(!addPart()) return false;
     }
-    inpoints.pop_back(); // remove last row which is invalid
+    if(rowLength.back() == 0) rowLength.pop_back(); // remove last row which is invalid
+    if(rowLength.empty()){
+        syslog::cout << "point cloud error: no rows found!\n";
+        return false;
+    }
 
-    size_t len = inpoints[0].size(), i=0;
-    
-    points.numVars = len - 1; // last column holds result - number of vars will be the column count - 1
+    size_t len = rowLength[0];
 
-    for(auto& row : inpoints){ // check for all rows to have the same size
-        if(len != row.size()){
+    for(size_t count : rowLength){ // check for all rows to have the same size
+        if(len != count){
             syslog::cout << "point cloud error: the row sizes do not match!\n";
             return false;
         }
-        ++i;
     }
-    std::vector<VTYPE> empty; // a blank / empty container of blank points
-    empty.resize(points.numVars, 0);
-    points.points.resize(inpoints.size(), empty); // preset the points with empty columns+rows
-    points.results.resize(inpoints.size(), 0.0); // preset the results
 
-    for(row = 0; row < inpoints.size(); row++){
-        for(size_t col = 0; col < inpoints[row].size(); col++){
-            if(col == points.numVars){ // result value
-                points.results[row] = inpoints[row][col]; // copy result
+    points.numVars = len - 1; // last column holds result - number of vars will be the column count - 1
+    points.clear();
+    points.resize(rowLength.size()); // preset the variable columns and results
+
+    for(row = 0; row < rowLength.size(); row++){
+        const VTYPE* line = &values[row * len];
+        for(size_t col = 0; col < len; col++){
+            if(col == size_t(points.numVars)){ // result value
+                points.results[row] = line[col]; // copy result
             } else { // variable value
-                points.points[row][col] = inpoints[row][col]; // copy variable
+                points.columns[col][row] = line[col]; // copy variable into its column
             }
         }
     }
@@ -0,0 +1,68 @@
+#include "operators.h"
+
+#include <numeric>
+#include <algorithm>
+
+namespace Operators {
+
+    template<typename T>
+    Variables BasicEqPoints<T>::point(size_t row) const {
+        Variables vars(numVars);
+        for(int v=0; v < numVars; ++v) vars[v] = columns[v][row];
+        return vars;
+    }
+
+    template<typename T>
+    void BasicEqPoints<T>::addPoint(const Variables& vars, VTYPE result) {
+        if(columns.size() != size_t(numVars)) columns.resize(numVars);
+        for(int v=0; v < numVars; ++v) columns[v].push_back(v < int(vars.size()) ? vars[v] : VTYPE(0));
+        results.push_back(result);
+    }
+
+    template<typename T>
+    void BasicEqPoints<T>::resize(size_t rows) {
+        columns.resize(numVars);
+        for(BasicColumn<T>& c : columns) c.resize(rows, 0);
+        results.resize(rows, 0);
+    }
+
+    template<typename T>
+    void BasicEqPoints<T>::clear() {
+        columns.clear();
+        results.clear();
+    }
+
+    template<typename T>
+    BasicEqPoints<T> BasicEqPoints<T>::subset(const std::vector<size_t>& rows) const {
+        BasicEqPoints sub;
+        sub.numVars = numVars;
+        sub.columns.resize(numVars);
+        for(int v=0; v < numVars; ++v){
+            BasicColumn<T>& c = sub.columns[v];
+            c.reserve(rows.size());
+            for(size_t r : rows) c.push_back(columns[v][r]);
+        }
+        sub.results.reserve(rows.size());
+        for(size_t r : rows) sub.results.push_back(results[r]);
+        return sub;
+    }
+
+    template<typename T>
+    void BasicEqPoints<T>::sortByVariable(int var) {
+        std::vector<size_t> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r){ return columns[var][l] < columns[var][r]; });
+        *this = subset(order);
+    }
+
+    template<typename T>
+    size_t BasicEqPoints<T>::memoryUsage() const {
+        size_t bytes = columns.capacity() * sizeof(BasicColumn<T>) + results.capacity() * sizeof(T);
+        for(const BasicColumn<T>& c : columns) bytes += c.capacity() * sizeof(T);
+        return bytes;
+    }
+
+    template struct BasicEqPoints<double>;
+    template struct BasicEqPoints<float>;
+
+}
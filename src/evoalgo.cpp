@@ -1,28 +1,71 @@
 #include "evoalgo.h"
 
+#include <cstring>
+
 using namespace NodeTypes;
 
-EvoAlgo::EvoAlgo(const Parameters* params, const Operators::EqPoints& data): params(params), data(data), generation(0), drawGraphCount(0) {
+EvoAlgo::EvoAlgo(const Parameters* params, const Operators::EqPoints& data): params(params), data(data), generation(0), drawGraphCount(0),
+    threadCount(params->singleThreaded ? 1 : std::max(1u, std::thread::hardware_concurrency())), scoreCutoff(INFINITY), fitnessMemory(0), compact(params->decimalPlacesExp) {
     RootNode::params = params; // update RootNode parameter pointer access
 
     if(!params->fitness.use) warning("Fitness algorithm is turned off!");
     if(params->singleThreaded) warning("Notice: User has enabled the single threaded feature - multi-threaded tasks will no longer run on more than 1 thread!");
     if(params->useCCMScoring) warning("useCCMScoring was enabled but this feature is currently not implemented yet");
+    debug(std::string("batch operators are using ") + Operators::batchLevelName(Operators::batchLevel()), true);
+    if(params->useNumaPlacement) debug("pinning workers to their NUMA node: " + Numa::topology(), true);
+    NodeResults::setMemoryBudget(params->incrementalCache.use ? params->incrementalCache.memoryBudget * 1024 * 1024 : 0);
+    if(params->scoringPrecision == Parameters::PRECISION_FLOAT){
+        floatData = Operators::BasicEqPoints<float>(data);
+        if(params->subtreeCache.use || params->incrementalCache.use) warning("Notice: the subtree and incremental caches keep double results - they are not used while scoring in float");
+    }
+    if(params->racing.use && (params->subtreeCache.use || params->incrementalCache.use || params->scoringPrecision == Parameters::PRECISION_FLOAT)){
+        warning("Notice: racing scores on a shuffled copy of the points in double - the subtree and incremental caches and float scoring are not used");
+    }
+    if(params->useIntervalScreen) intervalScreen.reset(data);
+    if(params->useCompactPopulation && (params->useVariableDescriptors || params->racing.use || params->subtreeCache.use || params->incrementalCache.use
+                                        || params->scoringPrecision == Parameters::PRECISION_FLOAT || params->popSave > 0)){
+        warning("Notice: the compact population does not use variable descriptors, racing, the subtree and incremental caches, float scoring or population copies");
+    }
+    if(params->usePipeline && !params->useCompactPopulation && (params->racing.use || params->subtreeCache.use || params->incrementalCache.use
+                                                                || params->scoringPrecision == Parameters::PRECISION_FLOAT || params->popSave > 0)){
+        warning("Notice: the pipelined generation does not use racing, the subtree and incremental caches, float scoring or population copies");
+    }
 
     graph = params->visual.graph; // get visual graph access
 
     scoreDatabase.resize(params->maxScoreHistory, INFINITY);
 
-    population.resize(params->popSize, nullptr); // construct a new population
+    if(params->useCompactPopulation){
+        scratch.resize(threadCount * 3, nullptr); // the individuals only become trees on the workers
+    } else {
+        population.resize(params->popSize, nullptr); // construct a new population
 
-    if(params->useVariableDescriptors){
-        shadowPopulation.resize(params->popSize, nullptr); // construct a new shadow population
+        if(params->useVariableDescriptors){
+            shadowPopulation.resize(params->popSize, nullptr); // construct a new shadow population
+        }
     }
 
-    float sz = double(calculatePoolSize()) * (double(population.size()) + double(shadowPopulation.size())) / 1024.f / 1024.f;
+    const size_t roots = population.size() + shadowPopulation.size() + scratch.size(),
+                 required = calculatePoolSize() * roots + (population.capacity() + shadowPopulation.capacity() + scratch.capacity()) * sizeof(RootNode*)
+                          + (params->useCompactPopulation ? 2 * params->popSize * sizeof(CompactPopulation::Individual) : 0)
+                          + data.memoryUsage() + floatData.memoryUsage(),
+                 budget = params->memoryBudget * 1024 * 1024;
+    if(budget > 0 && required > budget){ // the population cannot even start within the budget
+        throw std::runtime_error("memory budget of " + std::to_string(params->memoryBudget) + "MB cannot hold a population of " + std::to_string(roots)
+                                 + " root nodes - at least " + std::to_string(required / 1024 / 1024 + 1) + "MB are needed");
+    }
 
-    debug("pre-allocating population node pools: this will take approximately " + std::to_string(sz) + "MB of system memory", true);
-    threadGenerator(0, population.size(), &workRootNodeAllocator);
+    debug("pre-allocating population node pools: this will take " + std::to_string(double(required) / 1024 / 1024) + "MB of system memory", true);
+    if(params->useCompactPopulation){
+        for(RootNode*& rt : scratch) rt = new RootNode;
+        compact.begin(params->popSize, threadCount);
+        threadGenerator(0, params->popSize, &workCompactAllocator);
+        compact.commit();
+        sortCompact(selectionSize(compact.size()));
+        debug("compact population: " + std::to_string(compact.bytes() / 1024) + "KB of encoded trees for " + std::to_string(compact.size()) + " individuals", true);
+    } else {
+        threadGenerator(0, population.size(), &workRootNodeAllocator);
+    }
 
     /*
     for(size_t i=0; i < population.size(); ++i){
@@ -37,7 +80,7 @@ EvoAlgo::EvoAlgo(const Parameters* params, const Operators::EqPoints& data): par
     }
     */
 
-    sortPopulation();
+    sortPopulation(selectionSize(population.size()));
 }
 
 EvoAlgo::~EvoAlgo() {
@@ -47,8 +90,12 @@ EvoAlgo::~EvoAlgo() {
     for(RootNode* rt : shadowPopulation){
         delete rt;
     }
+    for(RootNode* rt : scratch){
+        delete rt;
+    }
     population.clear();
     shadowPopulation.clear();
+    scratch.clear();
 }
 
 // Mutate the passed root node randomly
@@ -72,40 +119,111 @@ void EvoAlgo::repopulate() {
 
     threadGenerator(cutoff, population.size(), &workRepopulate, &cutoff); // generate workers for the repopulation - give the cutoff region
 
+    // survivors and children go into one set of form hashes - a child whose form is already in it is mutated again
     debug("additional mutations for duplicates");
-    size_t count = 0, retry = 0; // keep track of total number of re-mutations
+    DuplicateRequest request;
+    request.cutoff = cutoff;
+    request.duplicates = 0;
+    formSet.reset(population.size());
+    formPending.assign(population.size(), 1);
+    threadGenerator(0, cutoff, &workRemoveDuplicates, &request); // every survivor is in the set before the first child is checked
+
+    size_t count = 0, rounds = 0; // keep track of total number of re-mutations
     do {
-        size_t unique = 0;
-        for(size_t i=cutoff; i < population.size(); ++i){ // find duplicate forms in newly populated area
-            RootNode& rt = *population[i];
-            // search for another node with the same form
-            auto itt = std::find_if(population.begin() + cutoff + i + 1, population.end(), [&](const RootNode* ort){
-                    return (ort->form == rt.form);
-                });
-            if( itt == population.end() ) { // did not find a match
-                ++unique;
-            } else { // found a duplicate - re-mutate then recalcualte
-                mutate(rt, 3); // mutate the duplicate nodes to remove duplicates
-                rt.calculateForm();
-            }
-        };
+        request.duplicates = 0;
+        threadGenerator(cutoff, population.size(), &workRemoveDuplicates, &request);
+        count += request.duplicates;
+    } while(request.duplicates && ++rounds != params->maxDuplicateRemoval); // 0 retries until no duplicates are left
 
-        if(unique < dead){
-            count += (dead - unique);
-        } else break; // no more duplicates found - break from duplicate finder
+    debug("duplicate removal: " + std::to_string(count) + " re-mutations of " + std::to_string(dead) + " children"
+          + (request.duplicates ? " - the " + std::to_string(request.duplicates) + " of the last round are not checked again" : std::string()));
+}
 
-        if(++retry == params->maxDuplicateRemoval) break; // break if reached max retries
-    } while(1); // must check for duplicates until no more are found
+// rank of a root as one integer - complete scores first, then the score, then the index for equal scores
+//   bit 63: rejected (clear when the bounds rank with the complete scores)   bits 31..62: score with its float bits flipped into unsigned order   bits 0..30: index
+static inline uint64_t rankKey(bool rejected, float score, size_t index) {
+    uint32_t bits;
+    std::memcpy(&bits, &score, sizeof(bits));
+    bits = std::isnan(score) ? UINT32_MAX : (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u); // NaN ranks last
+    return uint64_t(rejected) << 63 | uint64_t(bits) << 31 | index;
+}
 
-    if(count){
-        debug("finished accumulated re-mutation of " + std::to_string(count) + " root nodes");
-    }
+size_t EvoAlgo::selectionSize(size_t count) const {
+    const size_t survivors = std::round(params->popSize * params->survivalRatio),
+                 pivot = std::floor(params->survivalRatio * count) + 1; // minScore of the parsimony scoring
+    return std::min(count, std::max({survivors, pivot, size_t(5)})); // the 5 best are drawn
 }
 
-void EvoAlgo::sortPopulation() {
-    std::sort(population.begin(), population.end(), [](RootNode* l, RootNode* r) {
-        return (l->score < r->score); // sort population with best scores first to last
+void EvoAlgo::sortPopulation(size_t top, size_t worst, bool bounds) {
+    const size_t count = population.size();
+    if(count > (size_t(1) << 31)) throw std::runtime_error("sortPopulation is limited to " + std::to_string(size_t(1) << 31) + " root nodes");
+    top = std::min(top, count);
+    worst = std::min(worst, count - top);
+
+    // the keys are built and gathered on the workers for large populations - selecting on them is a single pass over one array
+    const size_t threads = (count >= (size_t(1) << 16) ? threadCount : 1);
+    auto parallel = [&](auto&& body){
+        if(threads == 1) body(0, count);
+        else workers.run(threads, [&](size_t t){ body(count * t / threads, count * (t + 1) / threads); });
+    };
+
+    selectionKeys.resize(count);
+    parallel([&](size_t begin, size_t end){
+        for(size_t i=begin; i < end; ++i) selectionKeys[i] = rankKey(population[i]->rejected && !bounds, population[i]->score, i);
+    });
+
+    // only the survivors need an order - the rest is split off around the pivot
+    const auto first = selectionKeys.begin(), last = selectionKeys.end();
+    if(top < count) std::nth_element(first, first + top, last);
+    std::sort(first, first + top);
+    if(worst > 0) std::nth_element(first + top, last - worst, last); // the worst roots at the end - popSave overwrites them
+
+    ranked.resize(count);
+    parallel([&](size_t begin, size_t end){
+        for(size_t i=begin; i < end; ++i) ranked[i] = population[selectionKeys[i] & 0x7FFFFFFFu];
     });
+    population.swap(ranked);
+}
+
+void EvoAlgo::sortCompact(size_t top, bool bounds) {
+    // the individual records are contiguous already - they are selected in place
+    auto better = [bounds](const CompactPopulation::Individual& l, const CompactPopulation::Individual& r) {
+        if(!bounds && l.rejected != r.rejected) return r.rejected; // completely scored individuals first - rejected scores are only lower bounds
+        return (l.score < r.score); // sort population with best scores first to last
+    };
+    const auto first = compact.individuals.begin(), last = compact.individuals.end();
+    top = std::min(top, compact.size());
+    if(top < compact.size()) std::nth_element(first, first + top, last, better);
+    std::sort(first, first + top, better);
+}
+
+float EvoAlgo::parsimonyScore(float rms, float complexity, float minScore) const {
+    double a = params->parsimony, b = 1 - a;
+    float acWeight = rms / minScore,
+          cxWeight = std::max(0., double(complexity - params->targetComplexity) / params->targetComplexity);
+    return a * acWeight + b * cxWeight;
+}
+
+size_t EvoAlgo::settleRejected(size_t top, float* minScore) {
+    // a rejected score is a lower bound of the real one and the parsimony score only grows with it, so the bounds rank
+    // together with the complete scores - once no bound reaches the top, every root below is at least as bad as the top
+    size_t settled = 0;
+    while(true){
+        size_t pending;
+        if(params->useCompactPopulation){
+            sortCompact(top, true);
+            const auto first = compact.individuals.begin();
+            pending = std::count_if(first, first + std::min(top, compact.size()), [](const CompactPopulation::Individual& ind){ return ind.rejected; });
+        } else {
+            sortPopulation(top, 0, true);
+            const auto first = population.begin();
+            pending = std::count_if(first, first + std::min(top, population.size()), [](const RootNode* rt){ return rt->rejected; });
+        }
+        if(pending == 0) return settled;
+        threadGenerator(0, std::min(top, params->useCompactPopulation ? compact.size() : population.size()),
+                        params->useCompactPopulation ? &workCompactSettleScore : &workSettleScore, minScore);
+        settled += pending;
+    }
 }
 
 // Threaded Workers:
@@ -116,6 +234,7 @@ void EvoAlgo::workRootNodeAllocator(EvoAlgo* _this, size_t i, size_t end, size_t
         RootNode*& rt = _this->population[i];
 
         rt = new RootNode;
+        rt->home = ThreadPool::workerIndex(); // the worker index of this thread
         // first node loaded from parameters
         if(i != 0 || !rt->parseRootNodeString(_this->params->precalculatedTree)){
             rt->node = (Node*) rt->createNode(RANDOM_OP, true);
@@ -128,6 +247,7 @@ void EvoAlgo::workRootNodeAllocator(EvoAlgo* _this, size_t i, size_t end, size_t
             RootNode*& shdrt = _this->shadowPopulation[i];
 
             shdrt = new RootNode;
+            shdrt->home = rt->home;
         }
         
     } while((i += spread) < end);
@@ -135,6 +255,7 @@ void EvoAlgo::workRootNodeAllocator(EvoAlgo* _this, size_t i, size_t end, size_t
 
 void EvoAlgo::workSimplifyScoreComplexity(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // score population worker
     if(i >= end) return; // pre-check
+    size_t rescored = 0;
     do {
         RootNode& rt = *_this->population[i];
 
@@ -145,7 +266,8 @@ void EvoAlgo::workSimplifyScoreComplexity(EvoAlgo* _this, size_t i, size_t end,
 
         if(_this->params->useVariableDescriptors){ // uses variable descriptors for calculating complexity
             RootNode& shdrt = *_this->shadowPopulation[i];
-            if(shdrt.node != nullptr) shdrt.node->freeAll();
+            if(_this->params->useArenaReset) shdrt.reset(); // the shadow tree is rebuilt every generation
+            else if(shdrt.node != nullptr) shdrt.node->freeAll();
 
             shdrt.node = rt.node->copy(&shdrt); // copy current root node to shadow root node for alternate complexity parsing
 
@@ -162,11 +284,24 @@ void EvoAlgo::workSimplifyScoreComplexity(EvoAlgo* _this, size_t i, size_t end,
         calculatedComplexity = std::fmin(calculatedComplexity, rt.node->computeComplexity());
 
         rt.complexity = calculatedComplexity; // update the complexity of the rootnode to the new calculated complexity
-        rt.score = rt.node->score(_this->data);
+
+        const uint64_t scoredForm = rt.formHash;
+        rt.calculateForm();
+        if(!rt.scored || rt.formHash != scoredForm){ // simplification changed the tree - an unchanged tree keeps its score and early abort verdict
+            if(_this->params->useEarlyAbort){
+                rt.score = rt.node->score(_this->data, _this->scoreCutoff, rt.rejected); // the same bound the children were scored with
+            } else {
+                rt.score = rt.node->score(_this->data);
+                rt.rejected = false;
+            }
+            rt.scored = true;
+            ++rescored;
+        }
 
         /// --------------------------- End Iteration
 
     } while((i += spread) < end);
+    if(extra != nullptr) *(std::atomic<size_t>*)extra += rescored;
 }
 
 void EvoAlgo::workScore(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // score population worker
@@ -175,12 +310,144 @@ void EvoAlgo::workScore(EvoAlgo* _this, size_t i, size_t end, size_t spread, voi
         RootNode& rt = *_this->population[i];
 
         /// --------------------------- Iteration
-        rt.score = rt.node->score(_this->data);
+        rt.scored = true;
+        if(_this->params->useIntervalScreen && _this->intervalScreen.screen(rt.node, rt.score) != IntervalScreen::EVALUATE){ // exact score without evaluating a point
+            rt.rejected = false;
+            continue;
+        }
+        const float bound = (_this->params->useEarlyAbort ? _this->scoreCutoff : INFINITY);
+        const NodeResults* known = (_this->params->incrementalCache.use && rt.results.dataset() == &_this->data ? &rt.results : nullptr); // results inherited from the parents
+        if(_this->params->scoringPrecision == Parameters::PRECISION_FLOAT){ // fast search score - settled in double once it can reach the pivot
+            rt.score = FloatProgram(rt.node).score(_this->floatData, bound, rt.rejected);
+            if(std::isinf(rt.score)){
+                rt.score = rt.node->score(_this->data, bound, rt.rejected); // float overflows much sooner - let double decide
+            } else {
+                rt.score *= 1 - FLOAT_SCORE_MARGIN; // a lower bound of the double score like any rejected score
+                rt.rejected = true;
+            }
+        } else if(_this->params->subtreeCache.use || known != nullptr){ // only compute the parts of the tree that are new
+            Program program(rt.node, known);
+            rt.score = (_this->params->subtreeCache.use ? _this->subtreeCache.score(program, _this->data, bound, rt.rejected) : program.score(_this->data, bound, rt.rejected));
+        } else if(_this->params->useEarlyAbort){
+            rt.score = rt.node->score(_this->data, bound, rt.rejected); // give up once it can't beat last generation's cutoff
+        } else {
+            rt.score = rt.node->score(_this->data);
+            rt.rejected = false;
+        }
         /// --------------------------- End Iteration
 
     } while((i += spread) < end);
 }
 
+void EvoAlgo::workRace(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // score the population on the current racing stage
+    if(i >= end) return; // pre-check
+    do {
+        float score;
+        if(_this->racing.firstStage() && _this->params->useIntervalScreen && _this->intervalScreen.screen(_this->population[i]->node, score) != IntervalScreen::EVALUATE){
+            _this->racing.finish(i, score);
+            continue;
+        }
+        _this->racing.advance(i, _this->population[i]->node);
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workSettleScore(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // full score of the rejected roots - parsimony score with a minScore
+    if(i >= end) return; // pre-check
+    const float* minScore = (const float*)extra;
+    do {
+        RootNode& rt = *_this->population[i];
+        if(!rt.rejected) continue;
+        rt.score = rt.node->score(_this->data);
+        rt.rejected = false;
+        rt.scored = (minScore == nullptr);
+        if(minScore != nullptr) rt.score = _this->parsimonyScore(rt.score, rt.complexity, *minScore);
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workCompactSettleScore(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // workSettleScore of the compact population
+    if(i >= end) return; // pre-check
+    const float* minScore = (const float*)extra;
+    RootNode& rt = *_this->scratch[ThreadPool::workerIndex() * 3 + 2];
+    do {
+        CompactPopulation::Individual& ind = _this->compact.individuals[i];
+        if(!ind.rejected) continue;
+        ind.score = _this->compact.decode(i, rt)->score(_this->data);
+        ind.rejected = false;
+        if(minScore != nullptr) ind.score = _this->parsimonyScore(ind.score, ind.complexity, *minScore);
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workCacheSubtrees(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // store the subtree results of the survivors
+    if(i >= end) return; // pre-check
+    do {
+        _this->subtreeCache.store(Program(_this->population[i]->node));
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workStoreResults(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // compute the node results of the survivors for their children
+    if(i >= end) return; // pre-check
+    do {
+        RootNode& rt = *_this->population[i];
+        rt.results.evaluate(rt.node, _this->data); // only the nodes edited since the last generation are computed
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workTrimPools(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // shrink the node pools back to the watermark
+    if(i >= end) return; // pre-check
+    TrimRequest& request = *(TrimRequest*)extra;
+    size_t released = 0;
+    do {
+        released += _this->population[i]->trim(request.watermark);
+        if(i < _this->shadowPopulation.size()) released += _this->shadowPopulation[i]->trim(request.watermark);
+    } while((i += spread) < end);
+    request.released += released;
+}
+
+size_t EvoAlgo::trimPools(double watermark) {
+    TrimRequest request {watermark, 0};
+    threadGenerator(0, population.size(), &workTrimPools, &request);
+    return request.released;
+}
+
+MemoryReport EvoAlgo::residentMemory() const {
+    MemoryReport report {0, 0, 0, 0, 0, 0, 0, 0, 0};
+    for(const Population* pop : {&population, &shadowPopulation, &scratch}){
+        report.rootNodes += pop->capacity() * sizeof(RootNode*);
+        for(const RootNode* rt : *pop){
+            if(rt == nullptr) continue;
+            report.rootNodes += sizeof(RootNode);
+            report.nodePools += rt->pool.memoryUsage();
+            if(rt->form.capacity() > std::string().capacity()) report.formStrings += rt->form.capacity() + 1; // beyond the short string buffer
+            report.nodeResults += rt->results.tableUsage();
+        }
+    }
+    report.formStrings += formSet.memoryUsage() + formPending.capacity();
+    report.compactTrees = compact.memoryUsage();
+    report.datasets = data.memoryUsage() + floatData.memoryUsage() + racing.memoryUsage() + scoreDatabase.capacity() * sizeof(float);
+    if(auto g = graph.lock()) report.visual = g->memoryUsage();
+    return report;
+}
+
+MemoryReport EvoAlgo::memoryReport() {
+    MemoryReport report = residentMemory();
+    report.nodeResults += NodeResults::takePeakMemory(); // the children that died in selection held results as well
+    report.subtreeCache = subtreeCache.takePeakMemory(); // the cache is already cleared at the end of a generation
+    report.fitness = fitnessMemory = Fitness::takePeakMemory();
+    return report;
+}
+
+size_t EvoAlgo::incrementalBudget() const {
+    const size_t inFlight = threadCount * 8 * data.size() * sizeof(VTYPE); // columns the workers hold while they evaluate trees that are not kept
+    return cacheBudget(params->incrementalCache.memoryBudget * 1024 * 1024, fitnessMemory + inFlight);
+}
+
+size_t EvoAlgo::cacheBudget(size_t configured, size_t others) const {
+    const size_t budget = params->memoryBudget * 1024 * 1024;
+    if(budget == 0) return configured;
+    const size_t used = residentMemory().total() + others;
+    return std::min(configured, budget - std::min(budget, used));
+}
+
 void EvoAlgo::workFitness(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // fitness iterator for a worker
     if(i >= end) return; // pre-check
     do {
@@ -188,11 +455,37 @@ void EvoAlgo::workFitness(EvoAlgo* _this, size_t i, size_t end, size_t spread, v
 
         /// --------------------------- Iteration
         rt.score = rt.node->score(_this->data, true); // use fitness evolution
+        rt.rejected = false;
+        rt.scored = false; // new constants - scored again after simplification
         /// --------------------------- End Iteration
 
     } while((i += spread) < end);
 }
 
+void EvoAlgo::workRemoveDuplicates(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) {
+    if(i >= end) return; // pre-check
+    DuplicateRequest& request = *(DuplicateRequest*)extra;
+    size_t duplicates = 0;
+    do {
+        RootNode& rt = *_this->population[i];
+
+        if(i < request.cutoff){ // simplification and fitness changed the survivor since its form was calculated
+            rt.calculateForm();
+            _this->formSet.insert(rt.formHash);
+        } else if(_this->formPending[i]){
+            if(_this->formSet.insert(rt.formHash)){
+                _this->formPending[i] = 0; // unique - it stays in the set
+            } else { // found a duplicate - re-mutate then recalculate, it is checked again in the next round
+                _this->mutate(rt, 3);
+                rt.calculateForm();
+                ++duplicates;
+            }
+        }
+
+    } while((i += spread) < end);
+    request.duplicates += duplicates;
+}
+
 void EvoAlgo::workRepopulate(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) {
     if(i >= end) return; // pre-check
     uint32_t cutoff = *(uint32_t*)extra; // get cutoff location
@@ -204,8 +497,12 @@ void EvoAlgo::workRepopulate(EvoAlgo* _this, size_t i, size_t end, size_t spread
         
         size_t origEq = 0, copyEq = 0; // index in population for the root nodes to copy from
         
-        rt.node->freeAll(); // free node from memory
-        rt.node = nullptr; // prevent bad pointer
+        if(_this->params->useArenaReset){
+            rt.reset(); // give back the whole dead tree at once
+        } else {
+            rt.node->freeAll(); // free node from memory
+            rt.node = nullptr; // prevent bad pointer
+        }
         rt.score = INFINITY; // reset score
 
         // pick a random index for the cross mutation
@@ -224,13 +521,13 @@ void EvoAlgo::workRepopulate(EvoAlgo* _this, size_t i, size_t end, size_t spread
                     * copyNode = _this->population[copyEq]->node; // the destination rot node for mutation
         
         // get list of all sub nodes in original node - also get list of nodes from root destination node
-        NodeList nls, ccl;
+        NodeBuffer nls, ccl; // per-thread scratch lists - no allocation once they have grown
 
-        origNode->listOfNodes(nls);
-        copyNode->listOfNodes(ccl);
+        origNode->collect(*nls);
+        copyNode->collect(*ccl);
         rt.node = origNode->copyMutate(&rt, // new root node to copy to
-                                        nls.all[Random::randomInt(nls.all.size() - 1)],
-                                        ccl.all[Random::randomInt(ccl.all.size() - 1)]); // crossover copy and generate new node
+                                        nls[Random::randomInt(nls->size() - 1)],
+                                        ccl[Random::randomInt(ccl->size() - 1)]); // crossover copy and generate new node
         
         rt.node->setParent(nullptr); // make sure the new root node doesn't have a parent!
 
@@ -247,22 +544,195 @@ void EvoAlgo::workRepopulate(EvoAlgo* _this, size_t i, size_t end, size_t spread
 
 }
 
+void EvoAlgo::workPipeline(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // one individual through a whole generation
+    if(i >= end) return; // pre-check
+    uint32_t cutoff = *(uint32_t*)extra; // get cutoff location
+    thread_local FlatTree child; // crossover buffer of this worker
+
+    do {
+        RootNode& rt = *_this->population[i];
 
-void EvoAlgo::threadGenerator(size_t start, size_t stop, Worker worker, void* extra) { // create workers to iterate over the list
-    const volatile size_t hardwarethreads = std::thread::hardware_concurrency(); // must be volatile because we are changing a constant! *queue Wow! sequence*
-    if(params->singleThreaded){
-        const_cast<size_t&>(hardwarethreads) = 1; // use one thread for debugging if user enabled single threaded
+        /// --------------------------- Iteration
+        if(i < cutoff){ // survivors optimize their constants - the children only read the snapshot
+            if(_this->params->fitness.use){
+                rt.score = rt.node->score(_this->data, true); // use fitness evolution
+                rt.rejected = false;
+            }
+        } else { // children are a cross mutation of two survivors (see workRepopulate)
+            size_t origEq = 0, copyEq = 0;
+            if(_this->params->weighedMutation){ // check if pick should be weighed toward lower scores from the previous generation
+                for(size_t k=0;k<cutoff; ++k)
+                    if(Random::chance(_this->params->weightChance)) {origEq = k; break;}
+                for(size_t k=0;k<cutoff; ++k)
+                    if(Random::chance(_this->params->weightChance)) {copyEq = k; break;}
+            } else {
+                origEq = Random::randomInt(cutoff-1);
+                copyEq = Random::randomInt(cutoff-1);
+            }
+
+            const FlatTree& orig = _this->survivorTrees[origEq],
+                          & copy = _this->survivorTrees[copyEq];
+            child.crossover(orig, Random::randomInt(orig.size() - 1), copy, Random::randomInt(copy.size() - 1)); // preorder positions - the same picks as the node lists
+
+            if(_this->params->useArenaReset){
+                rt.reset(); // give back the whole dead tree at once
+            } else {
+                rt.node->freeAll(); // free node from memory
+                rt.node = nullptr; // prevent bad pointer
+            }
+            rt.node = child.build(&rt);
+
+            if(Random::chance(_this->params->mutationChance)){ // the chance the new node will be mutated
+                _this->mutate(rt, _this->params->mutationCount); // mutate new child node
+            }
+        }
+
+        workSimplifyScoreComplexity(_this, i, i + 1, 1, nullptr); // simplify, complexity and the full score
+        /// --------------------------- End Iteration
+
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workCompactAllocator(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // generate the first compact population
+    if(i >= end) return; // pre-check
+    const size_t writer = ThreadPool::workerIndex(); // every worker writes its own chunk with its own scratch roots
+    RootNode& rt = *_this->scratch[writer * 3 + 2];
+    do {
+        rt.reset();
+        // first node loaded from parameters
+        if(i != 0 || !rt.parseRootNodeString(_this->params->precalculatedTree)){
+            rt.node = (Node*) rt.createNode(RANDOM_OP, true);
+            rt.node = rt.mutateAdd(3); // add 3 mutations to all nodes in the population
+        }
+        CompactPopulation::Individual& ind = _this->compact.write(writer, i, rt.node);
+        ind.score = rt.node->score(_this->data);
+        ind.complexity = rt.node->computeComplexity();
+    } while((i += spread) < end);
+}
+
+void EvoAlgo::workCompactGeneration(EvoAlgo* _this, size_t i, size_t end, size_t spread, void* extra) { // build, simplify and score one individual of the next compact generation
+    if(i >= end) return; // pre-check
+    uint32_t cutoff = *(uint32_t*)extra; // get cutoff location
+    const size_t writer = ThreadPool::workerIndex(); // every worker writes its own chunk with its own scratch roots
+    RootNode& orig = *_this->scratch[writer * 3],
+            & copy = *_this->scratch[writer * 3 + 1],
+            & rt = *_this->scratch[writer * 3 + 2];
+
+    do {
+        /// --------------------------- Iteration
+        const bool survivor = (i < cutoff);
+        if(survivor){ // survivors keep their tree - optimize its constants
+            _this->compact.decode(i, rt);
+            if(_this->params->fitness.use) rt.node->score(_this->data, true); // use fitness evolution - the score is taken again on every point below
+        } else { // children are a cross mutation of two survivors (see workRepopulate)
+            size_t origEq = 0, copyEq = 0;
+            if(_this->params->weighedMutation){ // check if pick should be weighed toward lower scores from the previous generation
+                for(size_t k=0;k<cutoff; ++k)
+                    if(Random::chance(_this->params->weightChance)) {origEq = k; break;}
+                for(size_t k=0;k<cutoff; ++k)
+                    if(Random::chance(_this->params->weightChance)) {copyEq = k; break;}
+            } else {
+                origEq = Random::randomInt(cutoff-1);
+                copyEq = Random::randomInt(cutoff-1);
+            }
+
+            _this->compact.decode(origEq, orig);
+            _this->compact.decode(copyEq, copy);
+            NodeBuffer nls, ccl;
+            orig.node->collect(*nls);
+            copy.node->collect(*ccl);
+
+            rt.reset();
+            rt.node = orig.node->copyMutate(&rt, nls[Random::randomInt(nls->size() - 1)], ccl[Random::randomInt(ccl->size() - 1)]); // crossover copy and generate new node
+            rt.node->setParent(nullptr);
+
+            if(Random::chance(_this->params->mutationChance)){ // the chance the new node will be mutated
+                _this->mutate(rt, _this->params->mutationCount); // mutate new child node
+            }
+        }
+
+        rt.simplify();
+        rt.complexity = rt.node->computeComplexity();
+        rt.rejected = false;
+        if(survivor){
+            rt.score = rt.node->score(_this->data);
+        } else if(!_this->params->useIntervalScreen || _this->intervalScreen.screen(rt.node, rt.score) == IntervalScreen::EVALUATE){
+            if(_this->params->useEarlyAbort) rt.score = rt.node->score(_this->data, _this->scoreCutoff, rt.rejected); // give up once it can't beat last generation's cutoff
+            else rt.score = rt.node->score(_this->data);
+        }
+
+        CompactPopulation::Individual& ind = _this->compact.write(writer, i, rt.node);
+        ind.score = rt.score;
+        ind.complexity = rt.complexity;
+        ind.rejected = rt.rejected;
+        /// --------------------------- End Iteration
+
+    } while((i += spread) < end);
+}
+
+namespace {
+    const char* workerName(EvoAlgo::Worker worker) {
+        static const std::pair<EvoAlgo::Worker, const char*> names[] = {
+            {&EvoAlgo::workRootNodeAllocator, "allocate"}, {&EvoAlgo::workSimplifyScoreComplexity, "simplify + score"},
+            {&EvoAlgo::workScore, "score"}, {&EvoAlgo::workCacheSubtrees, "cache subtrees"}, {&EvoAlgo::workStoreResults, "store results"},
+            {&EvoAlgo::workRace, "race"}, {&EvoAlgo::workFitness, "fitness"},
+            {&EvoAlgo::workTrimPools, "trim pools"}, {&EvoAlgo::workRepopulate, "repopulate"},
+            {&EvoAlgo::workRemoveDuplicates, "remove duplicates"},
+            {&EvoAlgo::workCompactAllocator, "allocate compact"}, {&EvoAlgo::workCompactGeneration, "compact generation"},
+            {&EvoAlgo::workPipeline, "pipeline"}, {&EvoAlgo::workSettleScore, "settle rejected"},
+            {&EvoAlgo::workCompactSettleScore, "settle rejected compact"}
+        };
+        for(const auto& n : names) if(n.first == worker) return n.second;
+        return "task";
     }
+}
 
-    std::vector<std::thread> threads;
+double EvoAlgo::taskCost(Worker worker, size_t i) const {
+    RootNode& rt = *population[i];
+    const double nodes = double(std::max<size_t>(1, rt.pool.getNodeCount()));
+    const bool fitness = (worker == &workFitness || (worker == &workPipeline && params->fitness.use && i < survivorTrees.size())); // pipelined survivors run fitness first
+    if(!fitness || rt.node == nullptr) return nodes;
+
+    // the fitness run scores its whole population once and then every iteration the part below its cutoff - but only with more than one constant
+    const size_t constants = rt.node->count(Node::KIND_CONSTANT);
+    const double evaluations = params->fitness.popSize
+                             + (constants > 1 ? params->fitness.numIterations * (params->fitness.popSize - std::round(params->fitness.popSize * params->fitness.cutOff)) : 0);
+    return nodes * evaluations;
+}
 
+void EvoAlgo::threadGenerator(size_t start, size_t stop, Worker worker, void* extra) { // run workers over the list on the persistent worker threads
     debug("begin a threaded task");
-    // Thread this iteration
-    for(size_t i=0; i < hardwarethreads; ++i){
-        threads.emplace_back(std::thread(worker, this, start + i, stop, hardwarethreads, extra));
+    if(params->useNumaPlacement && stop <= population.size()){
+        // every root goes back to the worker that allocated it - the sorted population mixes the roots, so each worker gets its own index list
+        std::vector<std::vector<size_t>> slices(threadCount);
+        for(size_t i=start; i < stop; ++i){
+            slices[population[i] == nullptr ? i % threadCount : population[i]->home % threadCount].push_back(i);
+        }
+        workers.run(threadCount, [&](size_t t){
+            Numa::pinWorker(t, threadCount); // the same worker index always runs on the same node
+            for(size_t i : slices[t]) worker(this, i, i + 1, 1, extra);
+            NodePool::flushNodeCount();
+        });
+    } else if(params->useWorkStealing && stop > start){
+        // the dead individuals of repopulate are replaced whatever their size - every other population task is weighed by its trees
+        const bool weighed = stop <= population.size() && worker != &workRepopulate && worker != &workRootNodeAllocator;
+        if(weighed){
+            taskCosts.resize(stop - start);
+            for(size_t i=start; i < stop; ++i) taskCosts[i - start] = taskCost(worker, i);
+        }
+        ThreadPool::Statistics stats = workers.forEach(threadCount, stop - start, [&](size_t k){
+            worker(this, start + k, start + k + 1, 1, extra);
+            NodePool::flushNodeCount(); // the worker threads never exit - hand in their node counts
+        }, weighed ? &taskCosts : nullptr);
+        debug(std::string("threaded ") + workerName(worker) + ": " + stats.string());
+        return;
+    } else {
+        // every index is handed to exactly one worker, which owns that root node while the task runs
+        workers.run(threadCount, [&](size_t t){
+            worker(this, start + t, stop, threadCount, extra);
+            NodePool::flushNodeCount(); // the worker threads never exit - hand in their node counts
+        });
     }
-
-    for(std::thread& t : threads) t.join();
     debug("finished a threaded task");
 }
 
@@ -271,7 +741,7 @@ void EvoAlgo::threadGenerator(size_t start, size_t stop, Worker worker, void* ex
 void EvoAlgo::drawGraph(RootNode& rt) {
     if(!graph.expired()){ // check if graph exists
         std::shared_ptr<VisualEvo::Graph> graph = this->graph.lock();
-        if(params->points.points.size()){ // check if there are actually any points to calculate
+        if(!params->points.empty()){ // check if there are actually any points to calculate
             uint32_t dvi = params->visual.drawVarIndex; // retrieve the variable index to draw
             if(params->visual.drawVarIndex >= params->points.numVars){ // check if variable index is within range
                 warning("VisualEvo drawVariableIndex is out of range - using last variable instead");
@@ -281,14 +751,14 @@ void EvoAlgo::drawGraph(RootNode& rt) {
             if(!drawGraphCount++){
                 graph->drawClear(); // clear graph after clear count reached
                 graph->drawAdd(params->points, dvi, 0x3209FF10, VisualEvo::Graph::BUBBLES); // original point cloud data
-                debug("Refresh Graph -> " + std::to_string(params->points.points.size()) + " points of data");
+                debug("Refresh Graph -> " + std::to_string(params->points.size()) + " points of data");
             }
 
             Operators::EqPoints data;   // calculate best rootnode tree here
             data.numVars = params->points.numVars; // force update the number of variables to prevent multi-variable crashing during the computing phase
 
-            rt.computeEquation(data, params->points.points.front()[dvi], // from lowest dvi value
-                                    params->points.points.back()[dvi]); // to highest dvi value
+            rt.computeEquation(data, params->points.columns[dvi].front(), // from lowest dvi value
+                                    params->points.columns[dvi].back()); // to highest dvi value
 
             float dist = float(drawGraphCount) / float(params->visual.clearCount);
             graph->drawAdd(data, 0, olc::Pixel(255, dist * 255, 10 + dist*100) ); // calculated .. the computeEquation takes the dvi value, and computes the result into value 0 
@@ -317,6 +787,8 @@ bool EvoAlgo::checkForMemoryConsistency() {
 };
 
 bool EvoAlgo::iteration() {
+    if(params->useCompactPopulation) return compactIteration();
+    if(params->usePipeline) return pipelineIteration();
     Clock timer, genTimer;
 
     generation++;
@@ -334,6 +806,13 @@ bool EvoAlgo::iteration() {
 
     // generate new population
     timer.restart();
+    if(params->incrementalCache.use && !params->racing.use){ // the children inherit the node results of the survivors they are copied from
+        debug("store survivor node results");
+        NodeResults::setMemoryBudget(incrementalBudget()); // the results of the population live in this cache
+        threadGenerator(0, std::round(params->popSize * params->survivalRatio), &workStoreResults);
+        debug(std::string("node results memory: ") + std::to_string(NodeResults::memoryUsage() / 1024 / 1024) + "MB");
+    }
+
     debug("repopulate()");
     repopulate();
     debug(timer.getMilliseconds());
@@ -341,13 +820,50 @@ bool EvoAlgo::iteration() {
     // update score
     timer.restart();
     debug("update score");
-    threadGenerator(0, population.size(), &workScore); // threaded scoring
-    debug(timer.getMilliseconds());
+    intervalScreen.resetStatistics();
+    if(params->incrementalCache.use && !params->racing.use){ // the children brought their forms and result tables along
+        NodeResults::setMemoryBudget(incrementalBudget());
+    }
+    if(params->racing.use){ // race the population through growing samples of the points
+        const size_t survivors = std::round(params->popSize * params->survivalRatio);
+        racing.reset(data, params->racing.initialSample, params->racing.growth);
+        racing.begin(population.size(), params->useEarlyAbort ? scoreCutoff : INFINITY);
+        do {
+            threadGenerator(0, population.size(), &workRace);
+            racing.eliminate(survivors, params->racing.margin, scoreCutoff);
+        } while(racing.nextStage());
+        for(size_t i=0; i < population.size(); ++i){ // eliminated racers have a lower bound - select() scores the ones near the cutoff in full
+            population[i]->score = racing.score(i, population[i]->rejected);
+            population[i]->scored = true; // simplification only rescores the trees it changes
+        }
+        debug(timer.getMilliseconds());
+        debug(racing.report());
+    } else {
+        if(params->subtreeCache.use){ // the children are made of the survivors' subtrees
+            subtreeCache.reset(&data, cacheBudget(params->subtreeCache.memoryBudget * 1024 * 1024, NodeResults::memoryUsage() + fitnessMemory));
+            threadGenerator(0, std::round(params->popSize * params->survivalRatio), &workCacheSubtrees);
+        }
+        threadGenerator(0, population.size(), &workScore); // threaded scoring
+        debug(timer.getMilliseconds());
+    }
+    if(params->subtreeCache.use && !params->racing.use){
+        debug(subtreeCache.report());
+        subtreeCache.clear(); // release the results until the next generation
+    }
+    if(params->useIntervalScreen) debug(intervalScreen.report());
+    if(params->useEarlyAbort || params->racing.use){
+        size_t rejected = std::count_if(population.begin(), population.end(), [](const RootNode* rt){ return rt->rejected; });
+        debug(std::string(params->racing.use ? "racing" : "early abort") + " rejected " + std::to_string(rejected) + " / " + std::to_string(population.size()) + " root nodes");
+    }
 
     // sort new scored population
     timer.restart();
     debug("sortPopulation()");
-    sortPopulation();
+    // float scores are bounds within FLOAT_SCORE_MARGIN - close enough to pick the fitness survivors, select() scores the ones it ranks in double
+    const bool floatScores = (params->scoringPrecision == Parameters::PRECISION_FLOAT && !params->racing.use);
+    const size_t copies = (params->fitness.use ? params->popSave : 0), // the fitness phase overwrites the worst roots with copies of the best
+                 ranks = std::max(selectionSize(population.size()), copies);
+    sortPopulation(ranks, copies, floatScores);
     debug(timer.getMilliseconds());
 
     // fitness cutoff for surviving population
@@ -366,6 +882,7 @@ bool EvoAlgo::iteration() {
             Node*& root = rt->node; // root node to overwrite
             root->freeAll(); // sorry but kill these last rootnodes to make room for the good copies
             root = population[i]->node->copy(rt); // update the root to a copy of the best node + popSave offset
+            rt->scored = false;
         }
         threadGenerator(0, bestLength, &workFitness); // generate threads
     }
@@ -375,48 +892,152 @@ bool EvoAlgo::iteration() {
     timer.restart();
     debug("simplification and re-score");
 
-    threadGenerator(0, population.size(), &workSimplifyScoreComplexity); // generate threads to simplify and solve the complexity
+    std::atomic<size_t> rescored(0);
+    threadGenerator(0, population.size(), &workSimplifyScoreComplexity, &rescored); // generate threads to simplify and solve the complexity
     debug(timer.getMilliseconds());
+    debug("re-scored " + std::to_string(rescored) + " / " + std::to_string(population.size()) + " root nodes changed by simplification, fitness or population copies");
 
-    // sort population after scoring for targeted complexities
+    select();
+    return finishGeneration(*population[0], genTimer);
+}
+
+void EvoAlgo::select() {
+    Clock timer;
+
+    // sort population after scoring for targeted complexities - rejected roots that could reach the pivot are scored in full
     timer.restart();
     debug("sortPopulation()");
-    sortPopulation();
+    const size_t ranks = selectionSize(population.size());
+    size_t settled = settleRejected(ranks);
     debug(timer.getMilliseconds());
 
     // update score based on user-defined parsimony and the target complexity
     timer.restart();
     debug("complexity and parsimony scoring");
-    float minScore = population[std::floor(params->survivalRatio * population.size())]->score;
-    double a = params->parsimony, b = 1 - a;
+    float minScore = population[std::floor(params->survivalRatio * population.size())]->score; // a complete score - the pivot is within the settled ranks
+    scoreCutoff = minScore; // the next generation's children must beat this RMS score to survive
 
     for(RootNode*& rt : population){
-        float acWeight = rt->score / minScore,
-              cxWeight = std::max(0., double(rt->complexity - params->targetComplexity) / params->targetComplexity);
-        rt->score = a * acWeight + b * cxWeight;
+        rt->score = parsimonyScore(rt->score, rt->complexity, minScore); // a lower bound stays a lower bound
+        rt->scored = false; // no longer an RMS score
     }
     debug(timer.getMilliseconds());
     
     // sort population after scoring for targeted complexities
     timer.restart();
     debug("sortPopulation()");
-    sortPopulation();
+    settled += settleRejected(ranks, &minScore);
+    debug(timer.getMilliseconds());
+    if(settled) debug("scored " + std::to_string(settled) + " rejected root nodes in full that could still reach the survivors");
+}
+
+bool EvoAlgo::pipelineIteration() {
+    Clock timer, genTimer;
+
+    generation++;
+    syslog::cout << "\n----------------------\nstarting generation " << generation << " / " << params->generationCount << "\n----------------------\n";
+
+    // the children are bred from a snapshot of the survivors, so the survivors can change while they are read
+    timer.restart();
+    debug("snapshot survivors");
+    uint32_t cutoff = std::round(params->popSize * params->survivalRatio);
+    survivorTrees.resize(cutoff);
+    for(size_t i=0; i < cutoff; ++i) survivorTrees[i].assign(population[i]->node);
+    debug(timer.getMilliseconds());
+
+    // every individual goes through fitness or breeding, simplify, complexity and score on its own
+    timer.restart();
+    debug("pipelined generation");
+    threadGenerator(0, population.size(), &workPipeline, &cutoff);
+    debug(timer.getMilliseconds());
+
+    select();
+    return finishGeneration(*population[0], genTimer);
+}
+
+bool EvoAlgo::compactIteration() {
+    Clock timer, genTimer;
+
+    generation++;
+    syslog::cout << "\n----------------------\nstarting generation " << generation << " / " << params->generationCount << "\n----------------------\n";
+
+    // repopulate, fitness, simplify, score and complexity of every individual in one pass
+    timer.restart();
+    debug("compact generation");
+    uint32_t cutoff = std::round(params->popSize * params->survivalRatio);
+    intervalScreen.resetStatistics();
+    compact.begin(compact.size(), threadCount);
+    threadGenerator(0, compact.size(), &workCompactGeneration, &cutoff);
+    compact.commit();
+    debug(timer.getMilliseconds());
+    if(params->useIntervalScreen) debug(intervalScreen.report());
+    debug("compact population: " + std::to_string(compact.bytes() / 1024) + "KB of encoded trees (" + std::to_string(double(compact.bytes()) / compact.size()) + " bytes per individual)");
+
+    timer.restart();
+    debug("sortCompact()");
+    const size_t ranks = selectionSize(compact.size());
+    size_t settled = settleRejected(ranks);
+    debug(timer.getMilliseconds());
+
+    // update score based on user-defined parsimony and the target complexity
+    timer.restart();
+    debug("complexity and parsimony scoring");
+    float minScore = compact.individuals[std::floor(params->survivalRatio * compact.size())].score;
+    scoreCutoff = minScore; // the next generation's children must beat this RMS score to survive
+
+    for(CompactPopulation::Individual& ind : compact.individuals){
+        ind.score = parsimonyScore(ind.score, ind.complexity, minScore);
+    }
+    settled += settleRejected(ranks, &minScore);
     debug(timer.getMilliseconds());
+    if(settled) debug("scored " + std::to_string(settled) + " rejected individuals in full that could still reach the survivors");
+
+    RootNode& best = *scratch[0]; // the workers are done - any scratch root can hold the best tree
+    compact.decode(0, best);
+    best.score = compact.individuals[0].score;
+    best.complexity = compact.individuals[0].complexity;
+    return finishGeneration(best, genTimer);
+}
+
+bool EvoAlgo::finishGeneration(RootNode& best, const Clock& genTimer) {
+    Clock timer;
 
     // update best scores to the score database
-    scoreDatabase.insert(scoreDatabase.begin(), population[0]->score);
+    scoreDatabase.insert(scoreDatabase.begin(), best.score);
     scoreDatabase.pop_back(); // remove oldest score
 
-    RootNode& best = *population[0];
     float ac_score = best.node->score(data); // calculate one more time for accuracy check
 
-    drawGraph(*population[0]); // draw again on graph
+    drawGraph(best); // draw again on graph
 
     if(Node::debugSkippedSimplify > 0){
         debug(std::string("Skipped ") + NodeTypes::FunctionNameString[params->denySimplifyOperator] + " simplify " + std::to_string(Node::debugSkippedSimplify) + " times");
         Node::debugSkippedSimplify = 0; // reset debugging counter
     }
 
+    if(params->usePoolTrim && !population.empty()){ // release the node memory of trees that shrank
+        timer.restart();
+        const size_t released = trimPools(params->poolWatermark);
+        NodePool::Statistics total {0, 0, 0, 0};
+        for(RootNode* rt : population){
+            NodePool::Statistics s = rt->pool.statistics();
+            total.capacity += s.capacity; total.live += s.live; total.free += s.free; total.peak += s.peak;
+        }
+        debug("node pools: " + std::to_string(total.live) + " live / " + std::to_string(total.capacity) + " capacity nodes (peak " + std::to_string(total.peak)
+              + ") - trimmed " + std::to_string(released / 1024) + "KB in " + std::to_string(timer.getMilliseconds()) + "ms");
+    }
+
+    {
+        MemoryReport memory = memoryReport();
+        const size_t budget = params->memoryBudget * 1024 * 1024;
+        if(budget > 0 && memory.total() > budget){ // over budget - keep nothing but the live nodes
+            const size_t released = trimPools(1.0);
+            memory.nodePools -= std::min(memory.nodePools, released);
+            if(memory.total() > budget) warning("memory budget of " + std::to_string(params->memoryBudget) + "MB exceeded after trimming the node pools - " + memory.string());
+        }
+        debug(memory.string());
+    }
+
     checkForMemoryConsistency();
 
     bool complete = ac_score <= params->accuracy || generation >= params->generationCount;
@@ -1,12 +1,46 @@
 #define REQUIRE_NODEPOOL
 #include "evorootnode.h"
+#include "flattree.h"
+#include "formset.h"
 
 using namespace NodeTypes;
 
 std::atomic<size_t> NodePool::totalCount(0); // tracker for all nodes
+const size_t NodePool::POOL_NODES = std::tuple_size<decltype(NodePool::Pool::nodes)>::value;
 
-NodePool::NodePool(): count(0) {
-    freeNode = preAllocateMemoryPool(); // preallocate first pool of memory - first empty node is returned
+#ifdef NODEPOOL_DEBUG
+    #define NODEPOOL_OWNER_CHECK() std::unique_lock<std::mutex> ownerCheck(tsafe, std::try_to_lock); \
+        if(!ownerCheck.owns_lock()) throw std::runtime_error("NodePool used by two threads at once - a RootNode must only be edited by the thread that owns it")
+#else
+    #define NODEPOOL_OWNER_CHECK()
+#endif
+
+thread_local NodePool::PendingNodes NodePool::pending;
+
+NodePool::PendingNodes::~PendingNodes() {
+    totalCount += delta;
+}
+
+void NodePool::trackNodes(long delta) {
+    pending.delta += delta;
+    if(std::abs(pending.delta) >= 1024){
+        totalCount += pending.delta;
+        pending.delta = 0;
+    }
+}
+
+void NodePool::flushNodeCount() {
+    totalCount += pending.delta;
+    pending.delta = 0;
+}
+
+size_t NodePool::getTotalNodeCount() {
+    flushNodeCount(); // include the changes of the calling thread
+    return totalCount;
+}
+
+NodePool::NodePool(RootNode* owner): owner(owner), freeNode(nullptr), curPool(0), used(0), count(0), peak(0) {
+    preAllocateMemoryPool(); // preallocate first pool of memory
 }
 
 NodePool::~NodePool() {
@@ -16,102 +50,114 @@ NodePool::~NodePool() {
 }
 
 uNode* NodePool::preAllocateMemoryPool() {
-    curMemPool = new Pool; // raw sub pool allocation
-    memPool.push_back(curMemPool); // add the new sub-pool to the significant memory pool
-    uNode* node = &curMemPool->at(0); // this is the address to the first node in the new pool
-
-    // pre-populate the fresh double-linked list with valid in-order pointers (with nullptr ends)
-    for(size_t i = 0; i < curMemPool->size(); ++i){
-        uNode *next, *prev;
-        next = (i == curMemPool->size()-1 ? nullptr : &(*curMemPool)[i+1]);
-        prev = (i == 0 ? nullptr : &(*curMemPool)[i-1]);
-
-        (*curMemPool)[i].n = next;
-        (*curMemPool)[i].p = prev;
+    Pool* pool = new Pool; // raw sub pool allocation - aligned to BLOCK_SIZE
+    if((reinterpret_cast<uintptr_t>(pool) + BLOCK_SIZE - 1) >> 48){ // nodes store their parent in 48 bits - checked once per block instead of every setParent
+        delete pool;
+        throw std::runtime_error("node pool block above the 48-bit address range - the compact node layout does not support this platform");
     }
-
-    return node;
+    pool->owner = owner; // every node finds its root through the block header
+    memPool.push_back(pool); // add the new sub-pool to the significant memory pool
+    return &pool->nodes[0];
 }
 
-void NodePool::deallocate_Node(Node* removeNode)  { // remove a node that must be in the given nodepool
-    std::scoped_lock lock(tsafe);
-    uNode* unode = removeNode->memory;
-    if(unode->n != freeNode){
-        if(unode->n != nullptr)
-            unode->n->p = unode->p; // collapse double linked list
-        if(unode->p != nullptr)
-            unode->p->n = unode->n; // collapse double linked list
-
-        unode->p = freeNode->p; // update previous node to last node allocated
-        if(unode->p != nullptr) // check if this is the first node in the system
-            unode->p->n = unode; // update next node on last allocated node
-
-        unode->n = freeNode; // update next node to the older next free node
-        unode->n->p = unode; // update previous node on the old next free node
+uNode* NodePool::allocateSlot() {
+    uNode* slot = freeNode;
+    if(slot != nullptr){
+        freeNode = slot->next; // pop the most recently freed node
+    } else {
+        if(used == memPool[curPool]->nodes.size()){ // current sub-pool is used up - move on to the next one
+            if(++curPool == memPool.size() && preAllocateMemoryPool() == nullptr){ // reached maximum pool size - automatically allocate the next sub-pool
+                throw std::runtime_error("Node allocation failed causing a critical failure");
+            }
+            used = 0;
+        }
+        slot = &memPool[curPool]->nodes[used++];
     }
-    freeNode = unode; // the next free node is now set to the current deallocated node
-    count--; // track node allocation
-    totalCount--;
-};
+    count++; // track node allocation
+    peak = std::max(peak, count);
+    trackNodes(1);
+    return slot;
+}
 
-bool NodePool::addLinkNewPool(uNode* lastNode) { // pass the last node in the previous pool, and free node will be autoset to the next free node in a new pool
-    freeNode = preAllocateMemoryPool(); // update freenode to the first node in the fresh memory pool (it's so clean!)
-    if(freeNode == nullptr) return false; // failed to allocate
+void NodePool::reset() {
+    NODEPOOL_OWNER_CHECK();
+    freeNode = nullptr;
+    curPool = used = 0;
+    trackNodes(-long(count));
+    count = 0;
+}
 
-    lastNode->n = freeNode; // link the new memory pool
-    freeNode->p = lastNode; // link the previous memory pool
-    /*   ...  [ e next-> [Y0]] } (X) <link sub pools> (Y) { [ [Xe] <-prev 0 ] ...   */
+size_t NodePool::trim(size_t maxNodes) {
+    NODEPOOL_OWNER_CHECK();
+    const size_t keep = std::max(curPool + 1, (maxNodes + POOL_NODES - 1) / POOL_NODES); // never below the sub-pool the arena is in
+    size_t released = 0;
+    while(memPool.size() > keep){
+        delete memPool.back();
+        memPool.pop_back();
+        released += sizeof(Pool);
+    }
+    return released;
+}
 
-    return true;
+size_t NodePool::memoryUsage() const {
+    return memPool.size() * sizeof(Pool) + memPool.capacity() * sizeof(Pool*);
 }
 
-OpNode* NodePool::allocate_OpNode() { // Instantiate the OpNode() in the array at position freeNode then increment freeNode pointer to the next node in the double linked list
-    std::scoped_lock lock(tsafe);
-    if(freeNode == nullptr){
-       throw std::runtime_error("Node allocation failed causing a critical failure");
-    }
-    freeNode->node.emplace<OpNode>(OpNode()); // emplace the node in the memory pool
-    OpNode* rval = &std::get<OpNode>(freeNode->node); // get the address of the new node instantiated in memory
-    if(freeNode == nullptr) {
-        warning("freeNode is empty");
-    }
-    rval->memory = freeNode;
-    freeNode = freeNode->n; // increment the next free node
-    count++; // track node allocation
-    totalCount++;
-    if(count >= curMemPool->size() || freeNode == nullptr){ // reached maximum pool size
-        addLinkNewPool(rval->memory); // automatically allocate and link the next sub-pool
-    }
-    return rval;
+NodePool::Statistics NodePool::statistics() const {
+    const size_t capacity = memPool.size() * POOL_NODES;
+    return Statistics {capacity, count, capacity - count, peak};
 }
 
-VarNode* NodePool::allocate_VarNode() { // Instantiate the VarNode() in the array at position freeNode then increment freeNode pointer to the next node in the double linked list
-    std::scoped_lock lock(tsafe);
-    if(freeNode == nullptr){
-       throw std::runtime_error("Node allocation failed causing a critical failure");
-    }
-    freeNode->node.emplace<VarNode>(VarNode()); // emplace the node in the memory pool
-    VarNode* rval = &std::get<VarNode>(freeNode->node); // get the address of the new node instantiated in memory
-    if(freeNode == nullptr) {
-        warning("freeNode is empty");
-    }
-    rval->memory = freeNode;
-    freeNode = freeNode->n; // increment the next free node
-    count++; // track node allocation
-    totalCount++;
-    if(count >= curMemPool->size()){ // reached maximum pool size
-        addLinkNewPool(rval->memory); // automatically allocate and link the next sub-pool
-    }
-    return rval;
+void NodePool::deallocate_Node(Node* removeNode)  { // remove a node that must be in the given nodepool
+    NODEPOOL_OWNER_CHECK();
+    uNode* unode = reinterpret_cast<uNode*>(removeNode); // nodes are trivially destructible - the slot is simply reused
+    unode->next = freeNode; // the most recently freed slot is handed out first while it is still in cache
+    freeNode = unode;
+    count--; // track node allocation
+    trackNodes(-1);
+};
+
+OpNode* NodePool::allocate_OpNode() { // Instantiate the OpNode() in the slot at the head of the free list
+    NODEPOOL_OWNER_CHECK();
+    return new (allocateSlot()->node) OpNode();
+}
+
+VarNode* NodePool::allocate_VarNode() { // Instantiate the VarNode() in the slot at the head of the free list
+    NODEPOOL_OWNER_CHECK();
+    return new (allocateSlot()->node) VarNode();
 }
 
 const Parameters* RootNode::params = nullptr; // static pointer for root node parameters
 
-RootNode::RootNode(): score(INFINITY), complexity(0), node(nullptr), lock(new std::mutex), form("") {} // defualt initialization of root node
+RootNode::RootNode(): score(INFINITY), complexity(0), rejected(false), scored(false), home(0), node(nullptr), form(""), formHash(0), pool(this) {} // defualt initialization of root node
 
 RootNode::~RootNode() {
-    delete lock; // free mutex
-    node->freeAll(); // free all nodes after completed
+    if(node != nullptr) node->freeAll(); // free all nodes after completed
+}
+
+size_t RootNode::trim(double watermark) {
+    const size_t keep = std::max(size_t(1), size_t(std::ceil(pool.getNodeCount() * std::max(1.0, watermark)))),
+                 allowed = (keep + NodePool::POOL_NODES - 1) / NodePool::POOL_NODES; // sub-pools
+    if(pool.memPool.size() <= allowed) return 0;
+
+    if(pool.curPool >= allowed && node != nullptr){ // the live nodes are spread over too many sub-pools - move them together
+        FlatTree flat(node);
+        results.clear(); // the nodes get new addresses
+        pool.reset();
+        node = flat.build(this);
+    }
+    return pool.trim(keep);
+}
+
+void RootNode::reset() {
+    results.clear(); // the node addresses are about to be reused
+    pool.reset();
+    node = nullptr;
+    form.clear();
+    score = INFINITY;
+    complexity = 0;
+    rejected = false;
+    scored = false;
 }
 
 int RootNode::validateNodeTree() {
@@ -120,36 +166,23 @@ int RootNode::validateNodeTree() {
            poolSize = pool.getNodeCount(),
            maximumPoolSize = 0;
 
-    for(NodePool::Pool* p : pool.memPool) maximumPoolSize += p->size(); /* raw calculation of the maximum pool size
-        (sub pools should always have the same size, but even so let's just calculate individually anyway. Kodi: *Woof!*) */
+    for(NodePool::Pool* p : pool.memPool){
+        maximumPoolSize += p->nodes.size(); // raw calculation of the maximum pool size
+        if(p->owner != this) syslog::cout << "found sub pool owned by another root node\n";
+    }
 
     if(node != nullptr){
-        NodeList list;
-        node->listOfNodes(list);
-        treeSize = list.all.size();
+        treeSize = node->count();
     }
     {
-        uNode* unode = nullptr;
-        for(NodePool::Pool* memPool : pool.memPool){
-            for(uNode& nn : *memPool){
-                if(&nn == pool.freeNode){
-                    unode = &nn;
-                    break;
-                }
-            }
-            if(unode == nullptr) continue; // this pool is full - try next pool
-        }
-        if(unode == nullptr){
-            syslog::cout << "found nodepool with no valid freenode\n";
-            return false;
-        }
-        while(unode != nullptr) {
-            unode = unode->p; // iterate backwards until we reach the first node
-            if(calcPoolSize++ == maximumPoolSize){
-                syslog::cout << "reached maximum pool size when searching for first node\n";
+        size_t freeSize = 0;
+        for(uNode* unode = pool.freeNode; unode != nullptr; unode = unode->next){ // every arena slot that is not on the free list is allocated
+            if(freeSize++ == maximumPoolSize){
+                syslog::cout << "reached maximum pool size when walking the free list\n";
+                return false;
             }
         }
-        calcPoolSize--; // compensate the freenode that we added
+        calcPoolSize = pool.curPool * pool.memPool[0]->nodes.size() + pool.used - freeSize;
     }
 
     if(poolSize != calcPoolSize){
@@ -176,18 +209,16 @@ bool RootNode::parseRootNodeString(const std::string& data) {
 // This calculates the form of the node tree into a string and updates the form string
 void RootNode::calculateForm() {
     form = node->form();
+    formHash = FormSet::hash(form);
 }
 
 // Compute the root tree with a given range of data points - updates given equation points given with the results and point range
 void RootNode::computeEquation(Operators::EqPoints& data, double from, double to, double precision) {
-	if(data.points.size() || data.results.size()) return; // do not calculate if non-empty given points
+	if(!data.empty()) return; // do not calculate if non-empty given points
     for(double i=from; i<to; i+=precision){
-		data.points.push_back({}); // add new variable range to data points
-        data.points.back().resize(data.numVars, i); // allocate point range for all variables - side note: this will affect the visual result greatly when using multi-variable equations
+        data.addPoint(Operators::Variables(data.numVars, i), 0); // add new variable range to data points - side note: this will affect the visual result greatly when using multi-variable equations
 	}
-    for(const Operators::Variables& v : data.points){
-        data.results.push_back( node->compute(v) ); // compute all points and update results
-    }
+    Program(node).computeAll(data, data.results); // compute all points and update results
 }
 
 // Call this simplify method for simplifying from a root - (may add a root parent if needed)
@@ -195,7 +226,7 @@ void RootNode::simplify(Node* parent) {
     do {
         Node* root = node->simplify(); // get new root node
         if(root != nullptr){ // if new root node
-            if(node->parent == parent) node->free(); // free original root node if no longer used - parent is typically nullptr
+            if(node->parent() == parent) node->free(); // free original root node if no longer used - parent is typically nullptr
             node = root; // update root node
             node->setParent(parent); // update the root's parent - this is usually nullptr and could cause problems if not
             continue; // re-simplify until nullptr
@@ -205,8 +236,6 @@ void RootNode::simplify(Node* parent) {
 }
 
 Node* RootNode::allocateOpNode(NodeTypes::FunctionName name, const Children& children, bool randomize){
-    static std::mutex threadsafe; std::scoped_lock lock(threadsafe);
-
     OpNode* n = pool.allocate_OpNode();
     n->ConstructOpNode(this, name, children, randomize);
 
@@ -214,8 +243,6 @@ Node* RootNode::allocateOpNode(NodeTypes::FunctionName name, const Children& chi
 }
 
 Node* RootNode::allocateVarNode(NodeTypes::FunctionName name, const Value& value, bool randomize){
-    static std::mutex threadsafe; std::scoped_lock lock(threadsafe);
-    
     VarNode* n = pool.allocate_VarNode();
     n->ConstructVarNode(this, name, value, randomize);
 
@@ -247,13 +274,14 @@ Node* RootNode::mutateChange(int numMutations) {
     const size_t len = params->operatorFunctions.size(); // get num operators
 
     Node* root = node;
+    NodeBuffer nodes; // scratch list of nodes - reused by every mutation
 
     while(numMutations-- > 0){
 
-        NodeList nodes; root->listOfNodes(nodes); // get fresh list of nodes
-        if(!nodes.all.size()) return root; // if no nodes were found - nothing to do
+        nodes->clear(); root->collect(*nodes); // get fresh list of nodes
+        if(!nodes->size()) return root; // if no nodes were found - nothing to do
 
-        Node* self = nodes.all[Random::randomInt(nodes.all.size() - 1)], // pick a random node in the tree
+        Node* self = nodes[Random::randomInt(nodes->size() - 1)], // pick a random node in the tree
             * newNode = self; // new node to be used - default is itself
 
         // new name for new mutation node
@@ -264,7 +292,7 @@ Node* RootNode::mutateChange(int numMutations) {
 
         bool newVarNode = (newName == CONSTANT || newName == VARIABLE); // quick check if new node is varnode or opnode
         bool freeMe = false; // determines if the old node is to be freed from memory
-        OpNode* p = (OpNode*)self->parent; // get original parent
+        OpNode* p = (OpNode*)self->parent(); // get original parent
 
         if(self->name == CONSTANT || self->name == VARIABLE) { // if self is varnode
             VarNode* me = (VarNode*)self;
@@ -314,7 +342,7 @@ Node* RootNode::mutateChange(int numMutations) {
         }
 
         if(freeMe) self->freeAll(); // destroy the node if it is no longer used
-        root->parent = nullptr;
+        root->setParent(nullptr);
     }
 
     return root;
@@ -325,15 +353,16 @@ Node* RootNode::mutateAdd(int numMutations) {
 
     Node* root = node;
     if(root == nullptr) return nullptr;
+    NodeBuffer nodes; // scratch list of nodes - reused by every mutation
 
     while(numMutations-- > 0){
-        NodeList nodes; root->listOfNodes(nodes); // get fresh list of nodes
-        if(!nodes.all.size()) return root; // if no nodes were found - nothing to do
+        nodes->clear(); root->collect(*nodes); // get fresh list of nodes
+        if(!nodes->size()) return root; // if no nodes were found - nothing to do
 
-        Node* self = nodes.all[Random::randomInt(nodes.all.size() - 1)]; // pick a random node in the tree
+        Node* self = nodes[Random::randomInt(nodes->size() - 1)]; // pick a random node in the tree
         OpNode* newNode = // new node to be used
             (OpNode*)createNode(RANDOM_OP); // create opnode with random operator, but not random operands
-        OpNode* p = (OpNode*)(self->parent);
+        OpNode* p = (OpNode*)(self->parent());
         
         newNode->setchild(Random::randomInt(newNode->arity - 1), self); // put new node on top of self/selected node
         
@@ -349,7 +378,7 @@ Node* RootNode::mutateAdd(int numMutations) {
             }
         }
 
-        root->parent = nullptr;
+        root->setParent(nullptr);
     }
 
     return root;
@@ -358,16 +387,17 @@ Node* RootNode::mutateAdd(int numMutations) {
 // Mutate Remove - Call on root node and set root node to return value
 Node* RootNode::mutateRemove(int numMutations) {
     Node* root = node;
+    NodeBuffer nodes; // scratch list of operators - reused by every mutation
 
     while(numMutations-- > 0){
-        NodeList nodes; root->listOfNodes(nodes); // get fresh list of nodes
+        nodes->clear(); root->collect(*nodes, Node::KIND_OPERATOR); // get fresh list of operators
 
-        if(!nodes.operators.size()) return root; // if no nodes were found - nothing to do
+        if(!nodes->size()) return root; // if no nodes were found - nothing to do
 
-        OpNode* self = (OpNode*)(nodes.operators[Random::randomInt(nodes.operators.size() - 1)]); // pick a random opnode in the tree
+        OpNode* self = (OpNode*)(nodes[Random::randomInt(nodes->size() - 1)]); // pick a random opnode in the tree
         int8_t idx = Random::randomInt(self->arity - 1);
         Node* replaceNode = self->child(idx),
-            * p = self->parent;
+            * p = self->parent();
         for(int i=0; i < self->arity; ++i){
             if(i == idx) continue;
             self->freechild(i, true); // kill the loose children that were not selected to become parent
@@ -381,7 +411,7 @@ Node* RootNode::mutateRemove(int numMutations) {
         }
 
         self->free(); // just free the node that was replaced so we don't kill the children
-        root->parent = nullptr;
+        root->setParent(nullptr);
     }
 
     return root;
@@ -392,17 +422,16 @@ Node* RootNode::findReplace(size_t varnum, const Node* replaceWith) {
     Node* root = node;
     if(root == nullptr) return nullptr;
 
-    NodeList nodes; root->listOfNodes(nodes); // get fresh list of nodes
-    if(!nodes.all.size()) return root; // if no nodes were found - nothing to do
+    NodeBuffer nodes; root->collect(*nodes, Node::KIND_VARIABLE); // snapshot of the variables - the tree changes below
 
-    for(Node* n : nodes.variables){
+    for(Node* n : *nodes){
         VarNode* v = static_cast<VarNode*>(n);
         if(v->name == VARIABLE && v->value.val == varnum){
             Node* newNode = replaceWith->copy(this); // new node tree from copy
             if(v == root){
                 root = newNode;
             } else {
-                OpNode* p = static_cast<OpNode*>(v->parent);
+                OpNode* p = static_cast<OpNode*>(v->parent());
                 for(int i=0;i < p->arity; ++i){
                     if(p->child(i) == v) { p->setchild(i, newNode); break; } // update the parent's child node to the replacement node
                 }
@@ -411,6 +440,6 @@ Node* RootNode::findReplace(size_t varnum, const Node* replaceWith) {
         }
     }
 
-    root->parent = nullptr;
+    root->setParent(nullptr);
     return root;
 }
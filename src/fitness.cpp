@@ -1,44 +1,58 @@
 #include "fitness.h"
 
-Fitness::Fitness(RootNode* rootnode, const Operators::EqPoints& odata, NodeList& rval): params(rootnode->params), root(rootnode->node), rList(rval) {
-    // Get root operator list of nodes
-    root->listOfNodes(rList);
+std::atomic<size_t> Fitness::liveBytes(0), Fitness::peakBytes(0);
 
-    // Copy data from original equation input data
-    data.numVars = odata.numVars;
-    data.results = odata.results;
-    data.points = odata.points;
+size_t Fitness::takePeakMemory() {
+    return peakBytes.exchange(liveBytes);
+}
+
+Fitness::Fitness(RootNode* rootnode, const Operators::EqPoints& odata): params(rootnode->params), root(rootnode->node) {
+    // Get the constant nodes of the root
+    root->collect(*rConstants, Node::KIND_CONSTANT);
 
     // Get randomized subset of point values (sampleSize sets the percentage)
-    const size_t sz = data.results.size(),
+    const size_t sz = odata.size(),
                  len = sz - std::round(params->fitness.sampleSize * float(sz));
     if(len > sz) throw std::runtime_error("Invalid sample size ratio");
 
+    std::vector<size_t> rows(sz); // rows of the original data that are kept
+    for(size_t i=0; i < sz; ++i) rows[i] = i;
     for(size_t i=0; i < len; ++i){ // iterate to remove random samples until sample size it met
         size_t pos = Random::randomInt(sz - 1 - i);
-        data.results.erase(data.results.begin() + pos);
-        data.points.erase(data.points.begin() + pos);
+        std::swap(rows[pos], rows[sz - 1 - i]); // move the removed row to the end
     }
+    rows.resize(sz - len);
+    std::sort(rows.begin(), rows.end()); // keep the original point order
+
+    data = odata.subset(rows); // copy the sampled rows into contiguous columns
 
     // Get population of the constants within the root
-    std::vector<VTYPE> def; def.resize(rList.constants.size(), 0); // construct a default list of empty constants
-    for(size_t i=0;i < rList.constants.size(); ++i){
-        def[i] = ((VarNode*)rList.constants[i])->value.val; // copy constant values into the default constants list
+    std::vector<VTYPE> def; def.resize(rConstants->size(), 0); // construct a default list of empty constants
+    for(size_t i=0;i < rConstants->size(); ++i){
+        def[i] = ((VarNode*)rConstants[i])->value.val; // copy constant values into the default constants list
     }
     population.resize(params->fitness.popSize, {INFINITY, def, nullptr, nullptr}); // construct an empty population
 
+    if(params->useCompiledScoring) program.compile(root); // the tree shape never changes here - only its constants
+
     // For now, the root node copy is null - making this a copy of the root node will allow for multi-threading support during population scoring
     //population.resize(params->fitness.popSize, {INFINITY, def, nullptr, nullptr, nullptr, false}); // construct an empty population with a root copy
     
     for(NodeScore& pop : population){ // root copy preparation - for all the root copies, prepare the copy's list of nodes
         //pop.rcopy = root->copy(); - do not use multithreading within the fitness function
         if(pop.rcopy != nullptr){
-            pop.rcList = new NodeList;
-            pop.rcopy->listOfNodes(*pop.rcList); // populate the list of nodes within all the root copies
+            pop.rcList = new std::vector<Node*>;
+            pop.rcopy->collect(*pop.rcList, Node::KIND_CONSTANT); // populate the list of nodes within all the root copies
         }
         //pop.lock = new std::mutex();
     }
 
+    bytes = sizeof(Fitness) + data.memoryUsage() + program.memoryUsage() + population.capacity() * sizeof(NodeScore)
+          + rConstants->capacity() * sizeof(Node*);
+    for(const NodeScore& pop : population) bytes += pop.constants.capacity() * sizeof(VTYPE);
+    const size_t live = (liveBytes += bytes);
+    for(size_t peak = peakBytes; live > peak && !peakBytes.compare_exchange_weak(peak, live);); // keep the highest total
+
     population[0].score = (population[0].rcopy == nullptr ?
                           root->score(data) : population[0].rcopy->score(data)); // update unchanged constants generation score
     mutateChangePopulation(1); // mutate change the rest of the constants for first generation
@@ -59,6 +73,7 @@ Fitness::~Fitness() {
         }
         */
     }
+    liveBytes -= bytes;
 }
 
 void Fitness::sortPopulation() {
@@ -96,6 +111,13 @@ void Fitness::mutateChange(NodeScore& rt) {
 
 void Fitness::updateScore(NodeScore& rt) {
     syncConstants(rt); // update the physical node's constants with the new constant data
+    if(rt.rcopy == nullptr && !program.empty()){ // compiled root - load the synced (rounded) constants into the program
+        for(size_t i=0; i < rConstants->size(); ++i){
+            program.constants[i] = ((VarNode*)rConstants[i])->value.val;
+        }
+        rt.score = program.score(data);
+        return;
+    }
     rt.score = (rt.rcopy == nullptr ? // check if using a root copy
                 root->score(data) : rt.rcopy->score(data)); // calculate RMS score
 }
@@ -122,10 +144,10 @@ void Fitness::updateScorePopulation(int startFrom) {
 }
 
 void Fitness::syncConstants(NodeScore& rt, bool toorig) {
-    NodeList& list = (rt.rcopy == nullptr || toorig ? // check if using the root copy node
-                      rList : *rt.rcList);
-    for(size_t i=0; i < list.constants.size(); ++i){
-        ((VarNode*)(list.constants[i]))->setVal(rt.constants[i]);
+    std::vector<Node*>& list = (rt.rcopy == nullptr || toorig ? // check if using the root copy node
+                      *rConstants : *rt.rcList);
+    for(size_t i=0; i < list.size(); ++i){
+        ((VarNode*)(list[i]))->setVal(rt.constants[i]);
     }
 }
 
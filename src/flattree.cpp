@@ -0,0 +1,116 @@
+#include "flattree.h"
+#include "node.h"
+
+#include <cstring>
+
+using namespace NodeTypes;
+
+FlatTree::FlatTree() {}
+
+FlatTree::FlatTree(const Node* root) {
+    assign(root);
+}
+
+void FlatTree::assign(const Node* root) {
+    slots.clear();
+    if(root != nullptr) flatten(root, NIL);
+}
+
+void FlatTree::assign(const Slot* data, size_t count) {
+    if(count > MAX_NODES) throw std::runtime_error("Flat tree is limited to " + std::to_string(MAX_NODES) + " nodes");
+    slots.assign(data, data + count);
+}
+
+FlatTree::Index FlatTree::flatten(const Node* node, Index parent) {
+    if(slots.size() >= MAX_NODES) throw std::runtime_error("Flat tree is limited to " + std::to_string(MAX_NODES) + " nodes");
+    const Index i = slots.size();
+    slots.push_back(Slot {uint8_t(node->name), node->arity, parent, {NIL, NIL}, node->isOperator() ? VTYPE(0) : node->value.val});
+    for(int c=0; c < node->arity; ++c){
+        const Index child = flatten(node->child(c), i); // may reallocate - index again afterwards
+        slots[i].children[c] = child;
+    }
+    return i;
+}
+
+Node* FlatTree::build(RootNode* root) const {
+    if(slots.empty()) return nullptr;
+    Node* node = build(root, 0);
+    node->setParent(nullptr);
+    return node;
+}
+
+Node* FlatTree::build(RootNode* root, Index i) const {
+    const Slot& s = slots[i];
+    if(s.arity == 0) return root->allocateVarNode(FunctionName(s.name), Value(s.value), false);
+
+    Node* node = root->allocateOpNode(FunctionName(s.name), {nullptr, nullptr}, false);
+    for(int c=0; c < s.arity; ++c) node->setchild(c, build(root, s.children[c]));
+    return node;
+}
+
+FlatTree::Index FlatTree::subtreeEnd(Index i) const {
+    while(slots[i].arity > 0) i = slots[i].children[slots[i].arity - 1]; // the last child of the last child... is the last slot
+    return i + 1;
+}
+
+void FlatTree::crossover(const FlatTree& a, Index at, const FlatTree& b, Index from) {
+    if(this == &a || this == &b){ // the sources are read while the buffer is written
+        FlatTree t;
+        t.crossover(a, at, b, from);
+        slots.swap(t.slots);
+        return;
+    }
+
+    const size_t aEnd = a.subtreeEnd(at), bEnd = b.subtreeEnd(from),
+                 removed = aEnd - at, inserted = bEnd - from,
+                 tail = a.size() - aEnd,
+                 total = a.size() - removed + inserted;
+    if(total > MAX_NODES) throw std::runtime_error("Flat tree is limited to " + std::to_string(MAX_NODES) + " nodes");
+
+    slots.resize(total);
+    Slot* out = slots.data();
+    std::memcpy(out, a.data(), at * sizeof(Slot)); // head of a - parents of the subtree and everything left of it
+    std::memcpy(out + at, b.data() + from, inserted * sizeof(Slot)); // subtree of b
+    std::memcpy(out + at + inserted, a.data() + aEnd, tail * sizeof(Slot)); // tail of a - everything right of the subtree
+
+    // indices into the tail of a move by the size difference, indices into b move to the new position
+    const Index grow = Index(inserted - removed); // wraps around when the tree shrinks - the indices still come out right
+    auto shiftTail = [&](Index& x){ if(x != NIL && x >= aEnd) x += grow; };
+    for(size_t i=0; i < at; ++i){
+        shiftTail(out[i].children[0]);
+        shiftTail(out[i].children[1]);
+    }
+    const Index move = Index(at - from);
+    for(size_t i=at; i < at + inserted; ++i){
+        out[i].parent += move;
+        if(out[i].children[0] != NIL) out[i].children[0] += move;
+        if(out[i].children[1] != NIL) out[i].children[1] += move;
+    }
+    out[at].parent = a[at].parent;
+    for(size_t i=at + inserted; i < total; ++i){
+        shiftTail(out[i].parent);
+        shiftTail(out[i].children[0]);
+        shiftTail(out[i].children[1]);
+    }
+}
+
+VTYPE FlatTree::compute(const Operators::Variables& vars, Index i) const {
+    const Slot& s = slots[i];
+    switch(s.arity){
+        case 0:
+            if(s.name == CONSTANT) return s.value;
+            return size_t(s.value) < vars.size() ? vars[size_t(s.value)] : VTYPE(0);
+        case 1: return RootNode::params->operatorList[s.name].function(compute(vars, s.children[0]), 0);
+        default: return RootNode::params->operatorList[s.name].function(compute(vars, s.children[0]), compute(vars, s.children[1]));
+    }
+}
+
+std::string FlatTree::string(Index i) const {
+    if(slots.empty()) return "";
+    const Slot& s = slots[i];
+    if(s.arity == 0) return s.name == CONSTANT ? std::to_string(s.value) : std::string("var") + std::to_string(int(s.value));
+
+    std::string str = FunctionNameString[s.name] + "(";
+    for(int c=0; c < s.arity; ++c) str += string(s.children[c]) + (c == s.arity-1 ? "" : ", ");
+    return str + ")";
+}
@@ -0,0 +1,46 @@
+#include "formset.h"
+
+#include <stdexcept>
+
+FormSet::FormSet(): slots(0), limit(0), count(0) {}
+
+void FormSet::reset(size_t forms) {
+    size_t size = 16;
+    while(size < 2 * forms) size <<= 1; // at most half full
+    if(size != slots){
+        table.reset(new std::atomic<uint64_t>[size]);
+        slots = size;
+    }
+    for(size_t i=0; i < slots; ++i) table[i].store(0, std::memory_order_relaxed);
+    limit = slots / 2;
+    count = 0;
+}
+
+bool FormSet::insert(uint64_t hash) {
+    if(hash == 0) hash = 1; // 0 marks the empty slots
+    const size_t mask = slots - 1;
+    for(size_t i = hash & mask;; i = (i + 1) & mask){
+        uint64_t seen = table[i].load(std::memory_order_relaxed);
+        if(seen == 0){
+            if(table[i].compare_exchange_strong(seen, hash, std::memory_order_relaxed)){
+                if(++count > limit) throw std::runtime_error("FormSet holds more than the " + std::to_string(limit) + " forms it was reset for");
+                return true;
+            }
+            // another worker took the slot first - it may have stored the same hash
+        }
+        if(seen == hash) return false;
+    }
+}
+
+uint64_t FormSet::hash(const std::string& form) {
+    uint64_t h = 0xcbf29ce484222325ull; // FNV-1a
+    for(unsigned char c : form) h = (h ^ c) * 0x100000001b3ull;
+    h ^= h >> 33; // spread the high bits into the low bits the table index uses
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    return h;
+}
+
+size_t FormSet::memoryUsage() const {
+    return slots * sizeof(std::atomic<uint64_t>);
+}
@@ -0,0 +1,179 @@
+#include "interval.h"
+#include "node.h"
+
+#include <algorithm>
+
+using namespace NodeTypes;
+
+Interval Interval::point(VTYPE value) {
+    if(std::isnan(value)) return alwaysNaN();
+    return Interval {value, value, false};
+}
+
+Interval Interval::whole(bool nan) {
+    return Interval {-INFINITY, INFINITY, nan};
+}
+
+Interval Interval::alwaysNaN() {
+    return Interval {INFINITY, -INFINITY, true};
+}
+
+// smallest interval holding every value - a NaN value means the rules cannot bound the result
+static Interval hull(std::initializer_list<VTYPE> values, bool nan) {
+    Interval r {INFINITY, -INFINITY, nan};
+    for(VTYPE v : values){
+        if(std::isnan(v)) return Interval::whole(true);
+        r.lo = std::min(r.lo, v);
+        r.hi = std::max(r.hi, v);
+    }
+    return r;
+}
+
+static inline bool unbounded(const Interval& i) {
+    return std::isinf(i.lo) || std::isinf(i.hi);
+}
+
+IntervalScreen::IntervalScreen(): sum(0), sumSquares(0), numPoints(0), screened(0), nan(0), constant(0) {}
+
+void IntervalScreen::reset(const Operators::EqPoints& data) {
+    variables.assign(data.numVars, Interval::alwaysNaN());
+    for(int v=0; v < data.numVars; ++v){
+        Interval& i = variables[v];
+        i.nan = false;
+        for(VTYPE x : data.columns[v]){
+            if(std::isnan(x)) i.nan = true;
+            else {
+                i.lo = std::min(i.lo, x);
+                i.hi = std::max(i.hi, x);
+            }
+        }
+    }
+
+    const VTYPE min = Parameters::Params()->minRMSClamp, max = Parameters::Params()->maxRMSClamp;
+    sum = sumSquares = 0;
+    for(VTYPE y : data.results){
+        const double a = std::clamp(y, min, max);
+        sum += a;
+        sumSquares += a * a;
+    }
+    numPoints = data.size();
+    resetStatistics();
+}
+
+void IntervalScreen::resetStatistics() {
+    screened = nan = constant = 0;
+}
+
+Interval IntervalScreen::evaluate(const Node* node) const {
+    if(node->arity == 0){
+        const VarNode* v = static_cast<const VarNode*>(node);
+        if(node->name == CONSTANT) return Interval::point(v->value.val);
+        const size_t index = size_t(v->value.val);
+        return (index < variables.size() ? variables[index] : Interval::point(0)); // missing variables compute as 0
+    }
+
+    const Interval a = evaluate(node->child(0)),
+                   b = (node->arity == 2 ? evaluate(node->child(1)) : Interval::point(0));
+    if(a.isPoint() && b.isPoint()) return Interval::point(static_cast<const OpNode*>(node)->function()(a.lo, b.lo)); // exact
+
+    if(a.isNaN() || b.isNaN()){ // NaN goes through every operator except where an operand is ignored
+        switch(node->name){
+            case POWER:{ // pow(1, y) and pow(x, 0) are 1
+                if((b.isPoint() && b.lo == 0) || (a.isPoint() && a.lo == 1)) return Interval::point(1);
+                if((b.isNaN() && a.contains(1)) || (a.isNaN() && b.contains(0))) return Interval {1, 1, true};
+                break;
+            }
+            case DIVIDE:{ // x / 0 is 0
+                if(b.isPoint() && b.lo == 0) return Interval::point(0);
+                if(a.isNaN() && b.contains(0)) return Interval {0, 0, true};
+                break;
+            }
+            default: break;
+        }
+        return Interval::alwaysNaN();
+    }
+
+    const bool nan = a.nan || b.nan;
+    switch(node->name){
+        case NEGATIVE: return Interval {-a.hi, -a.lo, a.nan};
+        case ABS:{
+            if(a.lo >= 0) return a;
+            if(a.hi <= 0) return Interval {-a.hi, -a.lo, a.nan};
+            return Interval {0, std::max(-a.lo, a.hi), a.nan};
+        }
+        case ADD: return hull({a.lo + b.lo, a.hi + b.hi}, nan || (a.contains(INFINITY) && b.contains(-INFINITY)) || (a.contains(-INFINITY) && b.contains(INFINITY)));
+        case SUBTRACT: return hull({a.lo - b.hi, a.hi - b.lo}, nan || (a.contains(INFINITY) && b.contains(INFINITY)) || (a.contains(-INFINITY) && b.contains(-INFINITY)));
+        case MULTIPLY: return hull({a.lo * b.lo, a.lo * b.hi, a.hi * b.lo, a.hi * b.hi}, nan || (a.contains(0) && unbounded(b)) || (b.contains(0) && unbounded(a)));
+        case DIVIDE:{ // division by zero is defined as 0
+            if(b.isPoint() && b.lo == 0) return Interval::point(0);
+            const bool infs = unbounded(a) && unbounded(b);
+            if(b.contains(0)) return Interval::whole(nan || infs);
+            return hull({a.lo / b.lo, a.lo / b.hi, a.hi / b.lo, a.hi / b.hi}, nan || infs);
+        }
+        case INVERSE:{
+            if(a.contains(0)) return Interval::whole(a.nan); // 1 / +-0 is +-inf
+            return hull({1 / a.lo, 1 / a.hi}, a.nan);
+        }
+        case POWER:{
+            if(b.isPoint()){
+                const VTYPE y = b.lo;
+                if(y == 0) return Interval::point(1);
+                if(std::isfinite(y) && y == std::round(y)){ // integer exponents are defined for negative bases
+                    if(a.contains(0) && y < 0) return Interval::whole(nan);
+                    Interval r = hull({std::pow(a.lo, y), std::pow(a.hi, y)}, nan);
+                    if(a.contains(0)){
+                        r.lo = std::min(r.lo, VTYPE(0));
+                        r.hi = std::max(r.hi, VTYPE(0));
+                    }
+                    return r;
+                }
+                if(std::isfinite(y) && a.hi < 0){ // negative base with a fractional exponent
+                    if(a.lo == -INFINITY) return Interval {std::pow(a.lo, y), std::pow(a.lo, y), true}; // only pow(-inf, y) is defined
+                    return Interval::alwaysNaN();
+                }
+            }
+            if(a.lo > 0){ // positive bases are monotone in both operands - the extremes are on the corners
+                return hull({std::pow(a.lo, b.lo), std::pow(a.lo, b.hi), std::pow(a.hi, b.lo), std::pow(a.hi, b.hi)}, nan);
+            }
+            return Interval::whole(nan || a.lo < 0);
+        }
+        case SIN:
+        case COS: return Interval {-1, 1, a.nan || unbounded(a)};
+        case TAN: return Interval::whole(a.nan || unbounded(a));
+        default: return Interval::whole(true);
+    }
+}
+
+IntervalScreen::Verdict IntervalScreen::screen(const Node* root, float& score) {
+    if(numPoints == 0) return EVALUATE;
+    ++screened;
+
+    const Interval r = evaluate(root);
+    if(r.isNaN()){
+        ++nan;
+        score = INFINITY; // a NaN error always scores INFINITY
+        return ALWAYS_NAN;
+    }
+    if(r.isPoint()){
+        ++constant;
+        score = constantScore(r.lo);
+        return CONSTANT_VALUE;
+    }
+    return EVALUATE;
+}
+
+float IntervalScreen::constantScore(VTYPE value) const {
+    const double c = std::clamp(value, Parameters::Params()->minRMSClamp, Parameters::Params()->maxRMSClamp);
+    const double error = sumSquares - 2 * c * sum + double(numPoints) * c * c; // sum of (result - c)^2
+    return Node::rmsFinalize(float(std::max(error, 0.)), numPoints);
+}
+
+IntervalScreen::Statistics IntervalScreen::statistics() const {
+    return Statistics {screened, nan, constant, (nan + constant) * numPoints};
+}
+
+std::string IntervalScreen::report() const {
+    Statistics s = statistics();
+    return "interval screen: " + std::to_string(s.nan) + " always NaN + " + std::to_string(s.constant) + " constant of " +
+           std::to_string(s.screened) + " trees - saved " + std::to_string(s.saved) + " point evaluations";
+}
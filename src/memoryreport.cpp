@@ -0,0 +1,18 @@
+#include "memoryreport.h"
+
+#include <sstream>
+#include <iomanip>
+
+size_t MemoryReport::total() const {
+    return nodePools + rootNodes + compactTrees + formStrings + nodeResults + subtreeCache + fitness + datasets + visual;
+}
+
+std::string MemoryReport::string() const {
+    auto mb = [](size_t bytes){ return double(bytes) / 1024.0 / 1024.0; };
+    std::ostringstream s;
+    s << std::fixed << std::setprecision(2)
+      << "memory: " << mb(total()) << "MB - node pools " << mb(nodePools) << "MB, root nodes " << mb(rootNodes)
+      << "MB, compact trees " << mb(compactTrees) << "MB, forms " << mb(formStrings) << "MB, node results " << mb(nodeResults) << "MB, subtree cache " << mb(subtreeCache)
+      << "MB, fitness " << mb(fitness) << "MB, datasets " << mb(datasets) << "MB, visual " << mb(visual) << "MB";
+    return s.str();
+}
@@ -1,10 +1,10 @@
 #include "node.h"
+#include "nodepool.h"
 
 using namespace NodeTypes;
 
 const Value NOVALUE;
 
-Value::Value(const Value& value): val(value.val), isSet(value.isSet) {}
 Value::Value(VTYPE value): val(value), isSet(true) {}
 Value::Value(): isSet(false) {}
 Value& Value::operator=(double rs) {
@@ -12,18 +12,47 @@ Value& Value::operator=(double rs) {
     isSet = true;
     return *this;
 }
-Value& Value::operator=(const Value& rs) {
-    val = rs.val;
-    isSet = rs.isSet;
-    return *this;
+
+
+/**
+ *      Traversal buffers:
+**/
+
+namespace {
+    struct NodeBuffers { // scratch vectors of one thread - freed when the thread ends
+        std::vector<std::vector<Node*>*> spare;
+        ~NodeBuffers() { for(std::vector<Node*>* b : spare) delete b; }
+    };
+    thread_local NodeBuffers nodeBuffers;
 }
 
-NodeList& NodeList::operator+=(const NodeList& rs) {
-    for(Node* n : rs.constants) constants.push_back(n);
-    for(Node* n : rs.operators) operators.push_back(n);
-    for(Node* n : rs.variables) variables.push_back(n);
-    for(Node* n : rs.all) all.push_back(n);
-    return *this;
+NodeBuffer::NodeBuffer() {
+    if(nodeBuffers.spare.empty()){
+        buffer = new std::vector<Node*>;
+        buffer->reserve(64);
+    } else {
+        buffer = nodeBuffers.spare.back();
+        nodeBuffers.spare.pop_back();
+    }
+}
+
+NodeBuffer::~NodeBuffer() {
+    buffer->clear(); // keeps its capacity for the next user
+    nodeBuffers.spare.push_back(buffer);
+}
+
+NodeCursor::NodeCursor(const Node* root, uint8_t kinds): kinds(kinds) {
+    if(root != nullptr) stack->push_back(const_cast<Node*>(root));
+}
+
+Node* NodeCursor::next() {
+    while(!stack->empty()){
+        Node* n = stack->back();
+        stack->pop_back();
+        for(int i=n->arity - 1; i >= 0; --i) stack->push_back(n->child(i)); // right child first so the left one comes out next
+        if(n->kind() & kinds) return n;
+    }
+    return nullptr;
 }
 
 
@@ -34,44 +63,90 @@ NodeList& NodeList::operator+=(const NodeList& rs) {
 std::atomic<size_t> Node::debugSkippedSimplify = 0;
 
 void Node::ConstructNode(RootNode* rootnode, FunctionName fname, Node* parent, const Children& _children, int8_t arity) {
-    rootNode = rootnode;
     name = fname;
-    this->parent = parent;
+    setParent(parent);
     this->arity = arity;
-    if(rootNode->params == nullptr) throw std::runtime_error("Parameters missing"); // cannot continue because parameters were denied
+    if(rootnode->params == nullptr) throw std::runtime_error("Parameters missing"); // cannot continue because parameters were denied
     children[0] = _children[0];
     children[1] = _children[1];
 
 }
 
-Node::Node(): memory(nullptr), parent(nullptr), rootNode(nullptr) { // initialize empty node
+Node::Node(): name(NONE), arity(0), parentBits{}, children{nullptr, nullptr} { // initialize empty node
 }
 
-Node::~Node() {
+RootNode* Node::rootNode() const {
+    return NodePool::blockOf(this)->owner;
 }
 
 void Node::free() {
-    rootNode->pool.deallocate_Node(this);
+    if(isOperator()){ // this method does NOT free the children
+        setchild(0, nullptr);
+        setchild(1, nullptr);
+    }
+    RootNode* root = rootNode();
+    if(!root->results.empty()) root->results.erase(this); // the memory may come back as another node - parents are invalidated when I am detached
+    root->pool.deallocate_Node(this);
+}
+
+void Node::invalidate() {
+    RootNode* root = rootNode();
+    if(!root->results.empty()) root->results.invalidate(this, root->pool.getNodeCount() + 1); // no path is longer than the tree
 }
 
 void Node::freeAll() {
+    if(isOperator()){
+        for(int i=0;i < arity; ++i){
+            freechild(i,true);
+        }
+    }
     free();
 }
 
+void Node::setchild(int idx, Node* c) {
+    if(!isOperator()){ WARNING_BAD_CALL("setchild"); return; }
+    children[idx] = c;
+    if(c != nullptr) c->setParent(this);
+    invalidate();
+}
+
+void Node::freechild(int idx, bool all) {
+    if(!isOperator()){ WARNING_BAD_CALL("freechild"); return; }
+    if(children[idx] != nullptr){
+        if(all) children[idx]->freeAll(); else children[idx]->free();
+        children[idx] = nullptr;
+        invalidate();
+    }
+}
+
+
+float Node::rmsCalculate(const Operators::EqPoints& points, const VTYPE* results) {
+    float sum = 0;
+    rmsAccumulate(points.results.data(), results, points.size(), sum);
+    return rmsFinalize(sum, points.size());
+}
 
-float Node::rmsCalculate(const std::vector<VTYPE>& actual, const std::vector<VTYPE>& results) {
-    if(actual.size() != results.size()) throw std::runtime_error("Equation points do not match the length of results!");
-    VTYPE min = Parameters::Params()->minRMSClamp , max = Parameters::Params()->maxRMSClamp;
-    float score = 0;
-    for(size_t i=0; i<actual.size(); ++i){
+template<typename T>
+void Node::rmsAccumulate(const T* actual, const T* results, size_t len, float& sum) {
+    const T min = Parameters::Params()->minRMSClamp , max = Parameters::Params()->maxRMSClamp;
+    float score = sum;
+    for(size_t i=0; i<len; ++i){
         // clamp the actual data and results to user-defined values
-        VTYPE sum = std::clamp(actual[i], min, max) - std::clamp(results[i], min, max);
-        score += std::pow(sum, 2);
+        T diff = std::clamp(actual[i], min, max) - std::clamp(results[i], min, max);
+        score += diff * diff;
     }
+    sum = score;
+}
+
+template void Node::rmsAccumulate<double>(const double*, const double*, size_t, float&);
+template void Node::rmsAccumulate<float>(const float*, const float*, size_t, float&);
+
+float Node::rmsFinalize(float sum, size_t len) {
+    float score = sum;
     if(std::isnan(score)){
         score = INFINITY;
     } else {
-        score /= float(actual.size());
+        score /= float(len);
         if(Parameters::Params()->useSqrtRMS)
             score = std::sqrt(score);
     }
@@ -102,13 +177,13 @@ double Node::computeComplexity() {
         }
     }
 
-    const ComplexityList& list = rootNode->params->complexity[name];
+    const ComplexityList& list = rootNode()->params->complexity[name];
     
     ComplexityList::const_iterator pos = std::find_if(list.begin(), list.end(),
             [&](ComplexityOp op) -> bool { return (ls == op.ls && rs == op.rs); }
         );
 
-    complexity += cumulative + (pos == list.end() ? rootNode->params->defaultComplexity : pos->complexity);
+    complexity += cumulative + (pos == list.end() ? rootNode()->params->defaultComplexity : pos->complexity);
 
     return complexity;
 }
@@ -118,6 +193,9 @@ Node* Node::copy(RootNode* newRootNode) const {
     for(int i=0; i < arity; ++i){ // copy all children if any
         node->setchild(i, child(i)->copy(newRootNode));
     }
+    if(!isOperator()) static_cast<VarNode*>(node)->setVal(value.val);
+    const RootNode* root = rootNode();
+    if(!root->results.empty()) newRootNode->results.inherit(node, root->results, this); // identical subtree - share my results
     return node;
 }
 
@@ -137,18 +215,30 @@ Node* Node::copyMutate(RootNode* newRootNode, const Node* to, const Node* from)
         ((VarNode*)node)->setVal(((VarNode*) this)->value.val);
         return node;
     }
+
+    const RootNode* root = rootNode();
+    if(!root->results.empty()){
+        for(const Node* n = to; n != nullptr; n = n->parent()){
+            if(n == this) return node; // the mutation branch is below me - my results no longer apply
+        }
+        newRootNode->results.inherit(node, root->results, this);
+    }
     return node;
 }
 
 // Call this function on the children nodes
 void Node::setParent(Node* parent) {
-    this->parent = parent;
+    const uint64_t p = reinterpret_cast<uintptr_t>(parent);
+#ifdef NODEPOOL_DEBUG
+    if(p >> 48) throw std::runtime_error("node address does not fit into 48 bits");
+#endif
+    std::memcpy(parentBits, &p, sizeof(parentBits)); // little endian - the low 6 bytes
 }
 
 // Call this function on the root node to iterate all children and update their parents
 void Node::updateLinks() {
     for(int i=0;i < arity;++i) {
-        if(child(i)->parent != this) {
+        if(child(i)->parent() != this) {
             child(i)->setParent(this);
             warning("found a broken child link!");
         }
@@ -156,11 +246,55 @@ void Node::updateLinks() {
     }
 }
 
-void Node::listOfNodes(NodeList& list) const {}
+void Node::collect(std::vector<Node*>& nodes, uint8_t kinds) const {
+    NodeCursor cursor(this, kinds);
+    while(Node* n = cursor.next()) nodes.push_back(n);
+}
+
+size_t Node::count(uint8_t kinds) const {
+    size_t total = 0;
+    for(NodeCursor cursor(this, kinds); cursor.next();) ++total;
+    return total;
+}
+
+Node::ReasonCode Node::validateNode() {
+    if(isOperator()) return static_cast<OpNode*>(this)->validateNode();
+    return static_cast<VarNode*>(this)->validateNode();
+}
+
+void Node::changeOperator(FunctionName fname) {
+    if(isOperator()) static_cast<OpNode*>(this)->changeOperator(fname);
+    else static_cast<VarNode*>(this)->changeOperator(fname);
+}
+
+VTYPE Node::compute(const Operators::Variables& vars) const {
+    if(isOperator()) return static_cast<const OpNode*>(this)->compute(vars);
+    return static_cast<const VarNode*>(this)->compute(vars);
+}
+
+VTYPE Node::compute(const Operators::EqPoints& points, size_t row) const {
+    if(isOperator()) return static_cast<const OpNode*>(this)->compute(points, row);
+    return static_cast<const VarNode*>(this)->compute(points, row);
+}
+
+std::string Node::string() const {
+    if(isOperator()) return static_cast<const OpNode*>(this)->string();
+    return static_cast<const VarNode*>(this)->string();
+}
+
+std::string Node::form() const {
+    if(isOperator()) return static_cast<const OpNode*>(this)->form();
+    return static_cast<const VarNode*>(this)->form();
+}
 
 void Node::cout(int level) const {
+    if(isOperator()) static_cast<const OpNode*>(this)->cout(level);
+    else static_cast<const VarNode*>(this)->cout(level);
+}
+
+void Node::coutLinks(int level) const {
     std::string tabs(level*4, ' ');
-    syslog::cout << tabs << "Parent: " << (parent == nullptr ? "null" : to_hex_string(parent)) << "\n"
+    syslog::cout << tabs << "Parent: " << (parent() == nullptr ? "null" : to_hex_string(parent())) << "\n"
               << tabs << "Children: " << (int)arity << "\n";
     
     syslog::cout << tabs << "**************************\n";
@@ -181,21 +315,43 @@ float Node::score(const Operators::EqPoints& points, bool evo) { // note that th
     float score;
     if(evo){
         // Use fitness evolution algorithm here - Kodi: *Woof!* *Woof!*
-        NodeList nodes;
-        Fitness fit(rootNode, points, nodes); // instantiate the fitness algorithm
+        Fitness fit(rootNode(), points); // instantiate the fitness algorithm
         score = fit.run(); // run the fitness algorithm magic and get the new score back
+    } else if(rootNode()->params->useCompiledScoring) {
+        score = Program(this).score(points); // flatten the tree and compute all points in blocks
     } else {
         std::vector<VTYPE> myResults;
-        myResults.reserve(points.results.size());
-        for(const Operators::Variables& vars : points.points){
-            myResults.push_back(compute(vars));
+        myResults.reserve(points.size());
+        for(size_t i=0; i < points.size(); ++i){
+            myResults.push_back(compute(points, i)); // no per point gather - variables read their column
         }
 
-        score = rmsCalculate(points.results, myResults);
+        score = rmsCalculate(points, myResults.data());
     }
     return score;
 }
 
+float Node::score(const Operators::EqPoints& points, float bound, bool& rejected) {
+    if(rootNode()->params->useCompiledScoring) return Program(this).score(points, bound, rejected);
+
+    std::vector<VTYPE> myResults(Program::BLOCK_SIZE);
+    float sum = 0;
+    rejected = false;
+    for(size_t start=0; start < points.size(); start += Program::BLOCK_SIZE){ // accumulate the error one block at a time
+        const size_t len = std::min(Program::BLOCK_SIZE, points.size() - start);
+        for(size_t i=0; i < len; ++i){
+            myResults[i] = compute(points, start + i);
+        }
+        rmsAccumulate(points.results.data() + start, myResults.data(), len, sum);
+
+        if(rmsFinalize(sum, points.size()) > bound){ // the remaining points can only add to the error
+            rejected = true;
+            break;
+        }
+    }
+    return rmsFinalize(sum, points.size());
+}
+
 
 Node* Node::simplify() {
     if(arity == 0) return nullptr;
@@ -205,12 +361,12 @@ Node* Node::simplify() {
         OpNode* c = (OpNode*) (child(i)->simplify());
         //OpNode* c = (OpNode*) (child(i)->simplify(me, i)); // Potential New Method
         if(c == nullptr) continue;
-        if(child(i)->parent == this) freechild(i); // free old memory
+        if(child(i)->parent() == this) freechild(i); // free old memory
         setchild(i, c); // update child (auto update parent)
 
     }
 
-    if(rootNode->params->denySimplifyOperator == name){
+    if(rootNode()->params->denySimplifyOperator == name){
         debugSkippedSimplify++; // counter increment
         return nullptr; // skip based on user defined parameter - do not simplify
     }
@@ -232,7 +388,7 @@ Node* Node::simplify() {
                     VarNode* n = opchild(0)->varchild(1);
                     n->setVal(n->value.val * VTYPE(-1)); // negate the constant
                 } else {
-                    r = rootNode->createNode(NEGATIVE); // negate exponent
+                    r = rootNode()->createNode(NEGATIVE); // negate exponent
                     r->setchild(0, opchild(0)->child(1)); // set child (auto-updates parent)
                     opchild(0)->setchild(1, r); // update exponent to negative operator (auto-updates parent)
                 }
@@ -699,7 +855,7 @@ Node* Node::simplify() {
                     r = opchild(0)->child(0); // get internal node
                     child(0)->setchild(0, this); // move inv op to the outside
                     setchild(0, r); // update the base
-                    return parent; // return my new parent
+                    return parent(); // return my new parent
                 }
             }
 
@@ -751,8 +907,8 @@ Node* Node::simplify() {
 
 Node::ReasonCode Node::validateNodeTree(RootNode* rootnode) {
 
-    if(rootNode != rootnode) return ROOTNODE_BAD_MEMORY;
-    if(rootNode->node == this && parent != nullptr) return ROOTNODE_BAD_PARENT;
+    if(rootNode() != rootnode) return ROOTNODE_BAD_MEMORY;
+    if(rootnode->node == this && parent() != nullptr) return ROOTNODE_BAD_PARENT;
 
     ReasonCode code = validateNode();
     if(code != SUCCESS) return code;
@@ -773,7 +929,7 @@ void VarNode::ConstructVarNode(RootNode* rootnode, FunctionName fname, const Val
     value = val;
 
     if((name == NONE && randomize) || name == RANDOM_VAR) { // no given function name
-        name = (Random::chance(rootNode->params->constantChance) ? CONSTANT : VARIABLE);
+        name = (Random::chance(rootNode()->params->constantChance) ? CONSTANT : VARIABLE);
     }
 
 
@@ -787,8 +943,8 @@ Node::ReasonCode VarNode::validateNode() {
     if(arity > 0) return ARITY;
     if(!value.isSet) return UNSET_VALUE;
     if(name != CONSTANT && name != VARIABLE) return INVALID_VARTYPE;
-    if(parent != nullptr){
-        if(parent->child(0) != this && parent->child(1) != this) return PARENTLINK;
+    if(parent() != nullptr){
+        if(parent()->child(0) != this && parent()->child(1) != this) return PARENTLINK;
     }
     return SUCCESS;
 }
@@ -797,13 +953,13 @@ Value& VarNode::setVal(VTYPE val) {
     switch(name){
         case CONSTANT:{
             int sign = std::signbit(val) ? -1 : 1;
-            if(std::abs(val) > rootNode->params->maxConstant){
+            if(std::abs(val) > rootNode()->params->maxConstant){
                 val = sign * INFINITY;
             }
-            if(std::abs(val) < rootNode->params->minConstant){
+            if(std::abs(val) < rootNode()->params->minConstant){
                 val = 0.f;
             }
-            value = std::round( val * VTYPE(rootNode->params->decimalPlacesExp) ) / VTYPE(rootNode->params->decimalPlacesExp);
+            value = std::round( val * VTYPE(rootNode()->params->decimalPlacesExp) ) / VTYPE(rootNode()->params->decimalPlacesExp);
             break;
         }
         case VARIABLE:{
@@ -811,17 +967,18 @@ Value& VarNode::setVal(VTYPE val) {
             break;
         }
     }
+    invalidate();
     return value;
 }
 
 void VarNode::randomizeValue() {
     switch(name) {
         case CONSTANT: {
-            setVal(Random::random() * rootNode->params->maxConstant * 2 - rootNode->params->maxConstant);
+            setVal(Random::random() * rootNode()->params->maxConstant * 2 - rootNode()->params->maxConstant);
             break;
         }
         case VARIABLE: {
-            setVal(Random::randomInt(rootNode->params->points.numVars - 1));
+            setVal(Random::randomInt(rootNode()->params->points.numVars - 1));
             break;
         }
     }
@@ -829,17 +986,7 @@ void VarNode::randomizeValue() {
 
 void VarNode::changeOperator(FunctionName name){
     this->name = name;
-}
-
-void VarNode::listOfNodes(NodeList& nodes) const {
-    Node* t = static_cast<Node*>(const_cast<VarNode*>(this)); // convert to editable node type
-    nodes += (name == CONSTANT ? NodeList {{}, {}, {t}, {t}} : NodeList {{}, {t}, {}, {t}});
-}
-
-Node* VarNode::copy(RootNode* newRootNode) const {
-    VarNode* node = (VarNode*)Node::copy(newRootNode); // parent inherited - get new node
-    node->setVal(value.val);
-    return node;
+    invalidate();
 }
 
 VTYPE VarNode::compute(const Operators::Variables& vars) const {
@@ -851,6 +998,15 @@ VTYPE VarNode::compute(const Operators::Variables& vars) const {
     return vars[size_t(value.val)];
 }
 
+VTYPE VarNode::compute(const Operators::EqPoints& points, size_t row) const {
+    if(name == CONSTANT) return value.val;
+    if(size_t(value.val) >= size_t(points.numVars)){
+        warning("found variable index out of bounds: " + std::to_string(value.val) + " reaches beyond " + std::to_string(points.numVars));
+        return VTYPE(0);
+    }
+    return points.columns[size_t(value.val)][row];
+}
+
 std::string VarNode::string() const{
     if(!value.isSet) return "N/A";
     return ( name == CONSTANT ? std::to_string(value.val) : std::string("var") + std::to_string(int(value.val)) );
@@ -864,7 +1020,7 @@ void VarNode::cout(int level) const {
     std::string tabs(level*4, ' ');
     syslog::cout << tabs << "Type: " << FunctionNameString[name] << "\n"
               << tabs << "Value: " << string() << "\n";
-    Node::cout(level);
+    coutLinks(level);
 }
 
 
@@ -877,27 +1033,26 @@ void OpNode::ConstructOpNode(RootNode* rootnode, FunctionName fname, const Child
     ConstructNode(rootnode, fname, nullptr, _children);
     
     if((name == NONE && randomize) || name == RANDOM_OP) { // no given function name
-        name = rootNode->params->operatorFunctions[ Random::randomInt(rootNode->params->operatorFunctions.size() - 1) ];
+        name = rootNode()->params->operatorFunctions[ Random::randomInt(rootNode()->params->operatorFunctions.size() - 1) ];
     }
 
-    arity = (rootNode->params->operatorList[name]).arity;
-    function = (rootNode->params->operatorList[name]).function;
+    arity = (rootNode()->params->operatorList[name]).arity;
 
     if(randomize){
         for(int i=0;i < arity;++i){
-            if(child(i) == nullptr) setchild(i, rootNode->createNode(RANDOM_VAR, true)); // create a random node
+            if(child(i) == nullptr) setchild(i, rootNode()->createNode(RANDOM_VAR, true)); // create a random node
         }
     }
 }
 
-OpNode::~OpNode() {
-    
+Operators::func OpNode::function() const {
+    return RootNode::params->operatorList[name].function;
 }
 
 Node::ReasonCode OpNode::validateNode() {
     if(arity == 0) return ARITY;
     bool found = false;
-    for(FunctionName n : rootNode->params->operatorFunctions){
+    for(FunctionName n : rootNode()->params->operatorFunctions){
         if(n == name){
             found = true;
             break;
@@ -907,55 +1062,41 @@ Node::ReasonCode OpNode::validateNode() {
 
     for(int i=0;i < arity; ++i){
         if(child(i) == nullptr) return i ? NULLCHILD_1 : NULLCHILD_0;
-        if(child(i)->parent != this) return i ? CHILDLINK_1 : CHILDLINK_0;
+        if(child(i)->parent() != this) return i ? CHILDLINK_1 : CHILDLINK_0;
     }
-    if(parent != nullptr){
-        if(parent->child(0) != this && parent->child(1) != this) return PARENTLINK;
+    if(parent() != nullptr){
+        if(parent()->child(0) != this && parent()->child(1) != this) return PARENTLINK;
     }
     return SUCCESS;
 }
 
-void OpNode::free() { // this method does NOT free its children
-    setchild(0, nullptr);
-    setchild(1, nullptr);
-    Node::free();
-}
-
-void OpNode::freeAll() {
-    for(int i=0;i < arity; ++i){
-        freechild(i,true);
-    }
-    Node::free();
-}
-
 VTYPE OpNode::compute(const Operators::Variables& vars) const {
     switch(arity){
-        case 1: return function(child(0)->compute(vars), 0);
-        case 2: return function(child(0)->compute(vars), child(1)->compute(vars));
+        case 1: return function()(child(0)->compute(vars), 0);
+        case 2: return function()(child(0)->compute(vars), child(1)->compute(vars));
     }
     return 0; // bad operator compute
 }
 
-void OpNode::listOfNodes(NodeList& nodes) const {
-    Node* t = static_cast<Node*>(const_cast<OpNode*>(this)); // convert to editable node type
-    nodes += NodeList {{t}, {}, {}, {t}}; // add this operator
-    
-    // add children nodes
-    for(int i=0;i < arity; ++i){
-        children[i]->listOfNodes(nodes);
+VTYPE OpNode::compute(const Operators::EqPoints& points, size_t row) const {
+    switch(arity){
+        case 1: return function()(child(0)->compute(points, row), 0);
+        case 2: return function()(child(0)->compute(points, row), child(1)->compute(points, row));
     }
+    return 0; // bad operator compute
 }
 
 void OpNode::changeOperator(FunctionName name){
     this->name = name;
-    function = rootNode->params->operatorList[name].function;
-    arity = rootNode->params->operatorList[name].arity;
+    arity = rootNode()->params->operatorList[name].arity;
+    invalidate();
 }
 
 void OpNode::swap() {
     Node* _tmp = children[0];
     children[0] = children[1]; // swap
     children[1] = _tmp; // swap
+    invalidate();
 }
 
 std::string OpNode::string() const {
@@ -991,5 +1132,5 @@ std::string OpNode::form() const {
 void OpNode::cout(int level) const {
     std::string tabs(level*4, ' ');
     syslog::cout << tabs << "Operator: " << string() << "\n";
-    Node::cout(level);
+    coutLinks(level);
 }
\ No newline at end of file
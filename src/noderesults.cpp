@@ -0,0 +1,82 @@
+#include "noderesults.h"
+#include "node.h"
+
+using namespace NodeTypes;
+
+std::atomic<size_t> NodeResults::totalBytes(0), NodeResults::peakBytes(0);
+size_t NodeResults::memoryBudget = 0;
+
+NodeResults::NodeResults(): points(nullptr) {}
+
+size_t NodeResults::tableUsage() const {
+    return results.bucket_count() * sizeof(void*) + results.size() * (sizeof(decltype(results)::value_type) + 2 * sizeof(void*)); // bucket array + one list node per entry
+}
+
+size_t NodeResults::takePeakMemory() {
+    return peakBytes.exchange(totalBytes);
+}
+
+void NodeResults::setMemoryBudget(size_t bytes) {
+    memoryBudget = bytes;
+}
+
+NodeResults::Result NodeResults::find(const Node* node) const {
+    auto it = results.find(node);
+    return (it == results.end() ? nullptr : it->second);
+}
+
+void NodeResults::erase(const Node* node) {
+    results.erase(node);
+}
+
+void NodeResults::invalidate(const Node* node, size_t maxDepth) {
+    for(; node != nullptr && maxDepth-- > 0; node = node->parent()){
+        results.erase(node);
+    }
+}
+
+void NodeResults::inherit(const Node* node, const NodeResults& source, const Node* original) {
+    if(source.points == nullptr) return;
+    if(points != source.points){ // results of another dataset are useless
+        results.clear();
+        points = source.points;
+    }
+    if(Result r = source.find(original)) results[node] = r;
+}
+
+void NodeResults::clear() {
+    results.clear();
+}
+
+NodeResults::Result NodeResults::evaluate(const Node* node, const Operators::EqPoints& points) {
+    if(this->points != &points){ // bind to the new dataset
+        results.clear();
+        this->points = &points;
+    }
+
+    if(node->arity == 0){ // leaves are never kept - variables are already a column
+        const VarNode* v = static_cast<const VarNode*>(node);
+        if(node->name != CONSTANT && size_t(v->value.val) < size_t(points.numVars)){
+            return Result(Result(), &points.columns[size_t(v->value.val)]); // non-owning
+        }
+        return std::make_shared<const Operators::Column>(points.size(), node->name == CONSTANT ? v->value.val : VTYPE(0));
+    }
+
+    if(Result r = find(node)) return r;
+
+    const OpNode* op = static_cast<const OpNode*>(node);
+    Result a = evaluate(node->child(0), points),
+           b = (node->arity == 2 ? evaluate(node->child(1), points) : a);
+
+    Operators::Column* out = new Operators::Column(points.size());
+    Operators::batchfunc batch = Operators::vectorize(op->function());
+    if(batch != nullptr) batch(a->data(), b->data(), out->data(), out->size());
+    else for(size_t i=0; i < out->size(); ++i) (*out)[i] = op->function()((*a)[i], node->arity == 2 ? (*b)[i] : 0);
+
+    const size_t bytes = out->capacity() * sizeof(VTYPE);
+    const size_t held = (totalBytes += bytes);
+    for(size_t peak = peakBytes; held > peak && !peakBytes.compare_exchange_weak(peak, held);); // keep the highest total
+    Result r(out, [bytes](const Operators::Column* c){ totalBytes -= bytes; delete c; }); // give the memory back to the budget when the last tree lets go
+    if(totalBytes <= memoryBudget) results[node] = r;
+    return r;
+}
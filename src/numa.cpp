@@ -0,0 +1,75 @@
+#include "numa.h"
+
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Numa {
+
+    static std::vector<int> parseCpuList(const std::string& list) { // "0-3,8-11"
+        std::vector<int> cpus;
+        std::stringstream ss(list);
+        std::string range;
+        while(std::getline(ss, range, ',')){
+            if(range.empty() || range == "\n") continue;
+            const size_t dash = range.find('-');
+            const int from = std::stoi(range.substr(0, dash)),
+                      to = (dash == std::string::npos ? from : std::stoi(range.substr(dash + 1)));
+            for(int c=from; c <= to; ++c) cpus.push_back(c);
+        }
+        return cpus;
+    }
+
+    static const std::vector<std::vector<int>>& nodes() { // cpus of every node
+        static const std::vector<std::vector<int>> topology = []{
+            std::vector<std::vector<int>> t;
+            for(int n=0;; ++n){ // node numbers are dense on almost every machine
+                std::ifstream f("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+                if(!f.is_open()) break;
+                std::string list;
+                std::getline(f, list);
+                std::vector<int> cpus = parseCpuList(list);
+                if(!cpus.empty()) t.push_back(cpus); // memory only nodes get no workers
+            }
+            return t;
+        }();
+        return topology;
+    }
+
+    size_t nodeCount() {
+        return std::max(size_t(1), nodes().size());
+    }
+
+    size_t nodeOfWorker(size_t worker, size_t workers) {
+        return worker * nodeCount() / std::max(workers, size_t(1));
+    }
+
+    bool pinWorker(size_t worker, size_t workers) {
+#ifdef __linux__
+        if(nodes().empty()) return false;
+        const size_t node = nodeOfWorker(worker, workers),
+                     first = (node * workers + nodeCount() - 1) / nodeCount(); // first worker of the node
+        const std::vector<int>& cpus = nodes()[node];
+        const int cpu = cpus[(worker - first) % cpus.size()];
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        return false;
+#endif
+    }
+
+    std::string topology() {
+        std::string s = std::to_string(nodeCount()) + " NUMA node" + (nodeCount() == 1 ? "" : "s");
+        for(size_t n=0; n < nodes().size(); ++n) s += (n ? ", " : " - ") + std::string("node ") + std::to_string(n) + ": " + std::to_string(nodes()[n].size()) + " cpus";
+        return s;
+    }
+
+}
@@ -84,6 +84,17 @@ Parameters::Parameters() {
     operatorChance = 50;    // chance that a change mutation will change the selected node to an opnode vs a varnode
     mutationChance = 50;    // chance that a mutation will occur during repopulation
     useSqrtRMS = true;      // additionally use sqrt when calculating RMS - turning this off might provide slightly better performance
+    useCompiledScoring = true; // compile node trees into a flat program before scoring instead of walking the tree for every point
+    useEarlyAbort = true;   // stop scoring new children once they are proven worse than the previous generation's survival cutoff
+    useIntervalScreen = true; // bound new trees with interval arithmetic - trees that are NaN on every point or constant skip the full evaluation
+    useArenaReset = true;   // clear dead individuals by resetting their node pool in one step instead of freeing every node
+    usePoolTrim = true;     // release unused node pool memory between generations
+    poolWatermark = 2.0;    // node pools are trimmed back to this many times their live nodes (at least one sub-pool)
+    useNumaPlacement = false; // pin the workers to NUMA nodes and keep every root on the worker that allocated it
+    useWorkStealing = true; // hand out the population in chunks that idle workers steal from each other - the most expensive individuals start first
+    usePipeline = false;    // run every individual through breeding or fitness, simplify, complexity and score on its own - selection is the only barrier of a generation
+    useCompactPopulation = false; // keep the population as byte encoded trees in one buffer - trees are only built while a worker mutates or scores them
+    memoryBudget = 0;       // maximum memory (MB) of the whole engine - caps both cache budgets, node pools are trimmed to their live nodes when it is exceeded (0 = unlimited)
     points.numVars = 1;     // the number of variables used in the given equation
     
 
@@ -102,6 +113,20 @@ Parameters::Parameters() {
     fitness.cutOff = 0.1;       // population cutoff ratio for the constants
     fitness.numIterations = 10; // number of generations the fitness will cycle (mutate, score, and sort)
     
+    // Default Subtree Cache Parameters
+    subtreeCache.use = true;            // share the results of common subtrees between the whole population while scoring
+    subtreeCache.memoryBudget = 512;    // maximum memory (MB) used for cached subtree results in each generation
+
+    // Default Incremental Cache Parameters
+    incrementalCache.use = false;           // survivors keep the results of their operator nodes so children only compute what changed
+    incrementalCache.memoryBudget = 1024;   // maximum memory (MB) used for the node results of the whole population
+
+    // Default Racing Parameters
+    racing.use = false;             // score new children on growing random samples of the points and eliminate the clearly bad ones early
+    racing.initialSample = 0.05;    // ratio of the points in the first sample
+    racing.growth = 4;              // every following sample is this many times larger than the previous one
+    racing.margin = 1.5;            // a racer is eliminated once its sample score is beyond this factor of the field
+
     // Default Visual Evo Parameters
     visual.display = true;      // display the VisualEvo window
     visual.closeOnFinish = true;// close the VisualEvo window when program finishes - otherwise program will stay running until user closes window
@@ -124,6 +149,7 @@ Parameters::Parameters() {
     };
 
     denySimplifyOperator = -1; // prevents the operator from being simplified (-1 is default and means this feature is disabled)
+    scoringPrecision = PRECISION_DOUBLE; // float scores are lower bounds of the double score - the ones that reach the survivors are scored again in double
     
     //Complexity For Operator / Variables Confiugrations
 
@@ -224,6 +250,17 @@ void Parameters::Load(const std::string& path) {
         json::loadProperty("operatorChance", globalParams->operatorChance);
         json::loadProperty("mutationChance", globalParams->mutationChance);
         json::loadProperty("useSqrtRMS", globalParams->useSqrtRMS);
+        json::loadProperty("useCompiledScoring", globalParams->useCompiledScoring);
+        json::loadProperty("useEarlyAbort", globalParams->useEarlyAbort);
+        json::loadProperty("useIntervalScreen", globalParams->useIntervalScreen);
+        json::loadProperty("useArenaReset", globalParams->useArenaReset);
+        json::loadProperty("usePoolTrim", globalParams->usePoolTrim);
+        json::loadProperty("poolWatermark", globalParams->poolWatermark);
+        json::loadProperty("memoryBudget", globalParams->memoryBudget);
+        json::loadProperty("useNumaPlacement", globalParams->useNumaPlacement);
+        json::loadProperty("useCompactPopulation", globalParams->useCompactPopulation);
+        json::loadProperty("useWorkStealing", globalParams->useWorkStealing);
+        json::loadProperty("usePipeline", globalParams->usePipeline);
         json::loadProperty("defaultCSV", globalParams->defaultPointCloudCSV);
         json::loadProperty("precalculatedTree", globalParams->precalculatedTree);
         json::loadProperty("verboseLogging", globalParams->verboseLogging);
@@ -240,6 +277,26 @@ void Parameters::Load(const std::string& path) {
         json::loadProperty(cfg, "changeChance", globalParams->fitness.changeChance);
     }
     
+    if(config.HasMember("subtreeCache") && config["subtreeCache"].IsObject()){
+        rapidjson::Value& cfg = config["subtreeCache"];
+        json::loadProperty(cfg, "enabled", globalParams->subtreeCache.use);
+        json::loadProperty(cfg, "memoryBudget", globalParams->subtreeCache.memoryBudget);
+    }
+
+    if(config.HasMember("incrementalCache") && config["incrementalCache"].IsObject()){
+        rapidjson::Value& cfg = config["incrementalCache"];
+        json::loadProperty(cfg, "enabled", globalParams->incrementalCache.use);
+        json::loadProperty(cfg, "memoryBudget", globalParams->incrementalCache.memoryBudget);
+    }
+
+    if(config.HasMember("racing") && config["racing"].IsObject()){
+        rapidjson::Value& cfg = config["racing"];
+        json::loadProperty(cfg, "enabled", globalParams->racing.use);
+        json::loadProperty(cfg, "initialSample", globalParams->racing.initialSample);
+        json::loadProperty(cfg, "growth", globalParams->racing.growth);
+        json::loadProperty(cfg, "margin", globalParams->racing.margin);
+    }
+
     if(config.HasMember("visualEvo") && config["visualEvo"].IsObject()){
         rapidjson::Value& cfg = config["visualEvo"];
         json::loadProperty(cfg, "enabled", globalParams->visual.display);
@@ -318,6 +375,13 @@ void Parameters::Load(const std::string& path) {
         }
     }
 
+    std::string precision;
+    if(json::loadProperty("scoringPrecision", precision)){
+        if(precision == "double") globalParams->scoringPrecision = PRECISION_DOUBLE;
+        else if(precision == "float") globalParams->scoringPrecision = PRECISION_FLOAT;
+        else warning("scoringPrecision must be \"double\" or \"float\": " + precision);
+    }
+
     // load complexity operator values
     if(config.HasMember("complexityWeights")){
         
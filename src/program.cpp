@@ -0,0 +1,182 @@
+#include "program.h"
+#include "node.h"
+
+using namespace NodeTypes;
+
+template<typename T>
+BasicProgram<T>::BasicProgram(): numSlots(0) {}
+
+template<typename T>
+BasicProgram<T>::BasicProgram(const Node* root, const NodeResults* known): numSlots(0) {
+    compile(root, known);
+}
+
+template<typename T>
+void BasicProgram<T>::compile(const Node* root, const NodeResults* known) {
+    code.clear();
+    constants.clear();
+    columns.clear();
+    numSlots = 0;
+    if(root == nullptr) return;
+    numSlots = emit(root, 0, known) + 1;
+}
+
+template<typename T>
+uint16_t BasicProgram<T>::emit(const Node* node, uint16_t slot, const NodeResults* known) {
+    Instruction ins {uint8_t(node->name), uint8_t(node->arity), slot, slot, slot, 0, nullptr, nullptr};
+    uint16_t used = slot;
+
+    if constexpr(std::is_same<T, VTYPE>::value){ // known results are only kept in VTYPE
+        if(known != nullptr && node->arity > 0){
+            if(NodeResults::Result r = known->find(node)){ // the whole subtree is already computed
+                code.push_back(Instruction {COLUMN, 0, slot, slot, slot, uint32_t(columns.size()), nullptr, nullptr});
+                columns.push_back(r->data());
+                return used;
+            }
+        }
+    }
+
+    switch(node->arity){
+        case 0:{ // leaf - variables and constants
+            const VarNode* v = static_cast<const VarNode*>(node);
+            if(node->name == CONSTANT){
+                ins.index = constants.size();
+                constants.push_back(v->value.val);
+            } else {
+                ins.index = uint32_t(v->value.val); // variables are an index of the function variable
+            }
+            break;
+        }
+        case 2:{ // left operand stays in my slot, right operand goes one slot above
+            used = std::max(used, emit(node->child(0), slot, known));
+            used = std::max(used, emit(node->child(1), slot + 1, known));
+            ins.b = slot + 1;
+            ins.function = static_cast<const OpNode*>(node)->function();
+            ins.batch = Operators::vectorize<T>(ins.function);
+            break;
+        }
+        case 1:{
+            used = std::max(used, emit(node->child(0), slot, known));
+            ins.function = static_cast<const OpNode*>(node)->function();
+            ins.batch = Operators::vectorize<T>(ins.function);
+            break;
+        }
+        default: throw std::runtime_error("More than 2 children found in Node");
+    }
+
+    code.push_back(ins);
+    return used;
+}
+
+template<typename T>
+T BasicProgram<T>::compute(const Operators::Variables& vars) const {
+    T out = 0;
+    Operators::BasicEqPoints<T> point;
+    point.numVars = vars.size();
+    point.addPoint(vars, 0);
+    computeBlock(point, 0, 1, &out);
+    return out;
+}
+
+template<typename T>
+void BasicProgram<T>::checkVariables(const Operators::BasicEqPoints<T>& points) const {
+    for(const Instruction& ins : code){ // check variable indices once instead of on every point
+        if(ins.arity == 0 && ins.op != CONSTANT && ins.op != COLUMN && ins.index >= size_t(points.numVars)){
+            warning("found variable index out of bounds: " + std::to_string(ins.index) + " reaches beyond " + std::to_string(points.numVars));
+        }
+    }
+}
+
+template<typename T>
+void BasicProgram<T>::evaluate(const Operators::BasicEqPoints<T>& points, size_t start, size_t len, T* out) const {
+    thread_local std::vector<T> scratch; // reusable slot memory for each worker thread
+    thread_local std::vector<const T*> operand; // current data of each slot - variables point straight into their column
+    if(scratch.size() < size_t(numSlots) * BLOCK_SIZE) scratch.resize(size_t(numSlots) * BLOCK_SIZE);
+    if(operand.size() < numSlots) operand.resize(numSlots);
+
+    for(const Instruction& ins : code){
+        T* dst = &scratch[size_t(ins.dst) * BLOCK_SIZE];
+        const T* a = operand[ins.a],
+                   * b = operand[ins.b];
+        switch(ins.arity){
+            case 0:{
+                if(ins.op == COLUMN){
+                    operand[ins.dst] = columns[ins.index] + start;
+                    continue;
+                }
+                if(ins.op != CONSTANT && ins.index < size_t(points.numVars)){
+                    operand[ins.dst] = points.columns[ins.index].data() + start; // no copy - read the column directly
+                    continue;
+                }
+                std::fill(dst, dst + len, ins.op == CONSTANT ? constants[ins.index] : T(0));
+                break;
+            }
+            case 1:{
+                if(ins.batch != nullptr) ins.batch(a, a, dst, len); // unary kernels ignore the second operand
+                else for(size_t i=0; i < len; ++i) dst[i] = ins.function(a[i], 0);
+                break;
+            }
+            case 2:{
+                if(ins.batch != nullptr) ins.batch(a, b, dst, len);
+                else for(size_t i=0; i < len; ++i) dst[i] = ins.function(a[i], b[i]);
+                break;
+            }
+        }
+        operand[ins.dst] = dst;
+    }
+
+    std::copy(operand[0], operand[0] + len, out); // slot 0 holds the root result
+}
+
+template<typename T>
+void BasicProgram<T>::computeBlock(const Operators::BasicEqPoints<T>& points, size_t from, size_t to, T* out) const {
+    checkVariables(points);
+    for(size_t start = from; start < to; start += BLOCK_SIZE){
+        evaluate(points, start, std::min(BLOCK_SIZE, to - start), out + (start - from));
+    }
+}
+
+template<typename T>
+void BasicProgram<T>::computeAll(const Operators::BasicEqPoints<T>& points, Operators::BasicColumn<T>& results) const {
+    results.resize(points.size());
+    computeBlock(points, 0, points.size(), results.data());
+}
+
+template<typename T>
+void BasicProgram<T>::accumulate(const Operators::BasicEqPoints<T>& points, size_t from, size_t to, float& sum) const {
+    T block[BLOCK_SIZE];
+    for(size_t start = from; start < to; start += BLOCK_SIZE){
+        const size_t len = std::min(BLOCK_SIZE, to - start);
+        evaluate(points, start, len, block);
+        Node::rmsAccumulate(points.results.data() + start, block, len, sum);
+    }
+}
+
+template<typename T>
+float BasicProgram<T>::score(const Operators::BasicEqPoints<T>& points) const {
+    bool rejected;
+    return score(points, INFINITY, rejected);
+}
+
+template<typename T>
+float BasicProgram<T>::score(const Operators::BasicEqPoints<T>& points, float bound, bool& rejected) const {
+    T block[BLOCK_SIZE];
+    float sum = 0;
+    rejected = false;
+    checkVariables(points);
+
+    for(size_t start = 0; start < points.size(); start += BLOCK_SIZE){
+        const size_t len = std::min(BLOCK_SIZE, points.size() - start);
+        evaluate(points, start, len, block);
+        Node::rmsAccumulate(points.results.data() + start, block, len, sum);
+
+        if(Node::rmsFinalize(sum, points.size()) > bound){ // the remaining points can only add to the error
+            rejected = true;
+            break;
+        }
+    }
+    return Node::rmsFinalize(sum, points.size());
+}
+
+template class BasicProgram<double>;
+template class BasicProgram<float>;
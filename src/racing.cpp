@@ -0,0 +1,120 @@
+#include "racing.h"
+#include "node.h"
+#include "random.h"
+
+#include <algorithm>
+
+Racing::Racing(): stage(0), bound(INFINITY), stats {0, 0, 0, 0} {}
+
+void Racing::reset(const Operators::EqPoints& data, double initialSample, double growth) {
+    std::vector<size_t> order(data.size());
+    for(size_t i=0; i < order.size(); ++i) order[i] = i;
+    for(size_t i = order.size(); i > 1; --i){ // shuffle - every stage samples a prefix of this order
+        std::swap(order[i - 1], order[Random::randomInt(i - 1)]);
+    }
+    points = data.subset(order);
+
+    stages.clear();
+    size_t end = std::max(Program::BLOCK_SIZE, size_t(initialSample * points.size())); // a stage is at least one block
+    while(end < points.size()){
+        stages.push_back(end);
+        end = std::max(end + Program::BLOCK_SIZE, size_t(end * growth));
+    }
+    stages.push_back(points.size());
+}
+
+void Racing::begin(size_t numRacers, float bound) {
+    racers.resize(numRacers);
+    for(Racer& r : racers){
+        r.sum = 0;
+        r.computed = 0;
+        r.score = INFINITY;
+        r.running = true;
+        r.rejected = false;
+    }
+    this->bound = bound;
+    stage = 0;
+    stats = {numRacers, 0, 0, numRacers * points.size()};
+}
+
+void Racing::advance(size_t racer, const Node* root) {
+    Racer& r = racers[racer];
+    if(!r.running) return;
+    if(r.computed == 0){
+        r.program.compile(root);
+        r.program.checkVariables(points);
+    }
+
+    r.program.accumulate(points, stageBegin(), stages[stage], r.sum);
+    r.computed = stages[stage];
+
+    const float full = Node::rmsFinalize(r.sum, points.size()); // lower bound of the full score - exact once every point is computed
+    if(std::isnan(r.sum) || full > bound || r.computed == points.size()){
+        r.score = full;
+        r.running = false;
+        r.rejected = (r.computed < points.size() && !std::isnan(r.sum));
+    }
+}
+
+void Racing::finish(size_t racer, float score) {
+    Racer& r = racers[racer];
+    r.score = score;
+    r.running = false;
+    r.rejected = false;
+}
+
+void Racing::eliminate(size_t survivors, double margin, float cutoff) {
+    if(stage + 1 >= stages.size()) return; // the last stage is exact
+
+    std::vector<float> samples; // sample scores of the racers still running
+    for(const Racer& r : racers){
+        if(r.running) samples.push_back(Node::rmsFinalize(r.sum, r.computed));
+    }
+    float field = cutoff;
+    if(survivors > 0 && survivors < samples.size()){
+        std::nth_element(samples.begin(), samples.begin() + (survivors - 1), samples.end());
+        field = std::min(field, samples[survivors - 1]);
+    }
+    const float threshold = margin * field;
+
+    for(Racer& r : racers){
+        if(!r.running) continue;
+        const float sample = Node::rmsFinalize(r.sum, r.computed);
+        if(sample > threshold){
+            r.score = Node::rmsFinalize(r.sum, points.size()); // the sample only ranks inside the race - the points left can only add to the error
+            r.running = false;
+            r.rejected = true;
+            ++stats.eliminated;
+        }
+    }
+}
+
+bool Racing::nextStage() {
+    return ++stage < stages.size();
+}
+
+float Racing::score(size_t racer, bool& rejected) const {
+    const Racer& r = racers[racer];
+    rejected = r.rejected;
+    return r.score;
+}
+
+size_t Racing::memoryUsage() const {
+    size_t bytes = points.memoryUsage() + stages.capacity() * sizeof(size_t) + racers.capacity() * sizeof(Racer);
+    for(const Racer& r : racers) bytes += r.program.memoryUsage();
+    return bytes;
+}
+
+Racing::Statistics Racing::statistics() const {
+    Statistics s = stats;
+    s.evaluated = 0;
+    for(const Racer& r : racers) s.evaluated += r.computed;
+    return s;
+}
+
+std::string Racing::report() const {
+    Statistics s = statistics();
+    return "racing: " + std::to_string(s.evaluated) + " / " + std::to_string(s.baseline) + " point evaluations (" +
+           std::to_string(s.baseline ? 100 - 100 * s.evaluated / s.baseline : 0) + "% saved) - eliminated " +
+           std::to_string(s.eliminated) + " / " + std::to_string(s.racers) + " racers in " + std::to_string(stages.size()) + " stages";
+}
@@ -0,0 +1,154 @@
+#include "subtreecache.h"
+#include "node.h"
+
+#include <cstring>
+
+using namespace NodeTypes;
+
+SubtreeCache::SubtreeCache(size_t numShards): shards(std::max(numShards, size_t(1))), points(nullptr), memoryBudget(0),
+    hits(0), misses(0), skipped(0), entries(0), bytes(0), peakBytes(0) {}
+
+void SubtreeCache::reset(const Operators::EqPoints* points, size_t memoryBudget) {
+    clear();
+    this->points = points;
+    this->memoryBudget = memoryBudget;
+    hits = misses = skipped = 0;
+}
+
+void SubtreeCache::clear() {
+    for(Shard& s : shards){
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.results.clear();
+    }
+    entries = bytes = 0;
+}
+
+SubtreeCache::Result SubtreeCache::find(const std::string& key) {
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto it = s.results.find(key);
+    if(it == s.results.end()) return nullptr;
+    return it->second;
+}
+
+SubtreeCache::Result SubtreeCache::insert(const std::string& key, Operators::Column&& result) {
+    const size_t size = result.capacity() * sizeof(VTYPE) + key.size();
+    Result stored = std::make_shared<const Operators::Column>(std::move(result));
+    if(bytes + size > memoryBudget){ // out of memory - the result is still returned to the caller
+        ++skipped;
+        return stored;
+    }
+
+    Shard& s = shard(key);
+    std::lock_guard<std::mutex> guard(s.lock);
+    auto ins = s.results.emplace(key, stored);
+    if(ins.second){
+        ++entries;
+        const size_t held = (bytes += size);
+        for(size_t peak = peakBytes; held > peak && !peakBytes.compare_exchange_weak(peak, held);); // keep the highest total
+    }
+    return ins.first->second;
+}
+
+SubtreeCache::Encoding::Encoding(const Program& program): keys(program.code.size()), starts(program.code.size()) {
+    for(size_t i=0; i < program.code.size(); ++i){
+        const Program::Instruction& ins = program.code[i];
+        switch(ins.arity){
+            case 0:{
+                char leaf[1 + sizeof(uint64_t)] = {char(ins.op)}; // large enough for a constant or a column pointer
+                if(ins.op == CONSTANT) std::memcpy(leaf + 1, &program.constants[ins.index], sizeof(VTYPE)); // constants are compared bit for bit
+                else if(ins.op == Program::COLUMN) std::memcpy(leaf + 1, &program.columns[ins.index], sizeof(VTYPE*)); // never stored - only looked up
+                else std::memcpy(leaf + 1, &ins.index, sizeof(ins.index));
+                keys[i].assign(leaf, sizeof(leaf));
+                starts[i] = i;
+                break;
+            }
+            case 1:{
+                keys[i] = keys[i - 1] + char(ins.op);
+                starts[i] = starts[i - 1];
+                break;
+            }
+            case 2:{ // the right operand ends right before me - the left operand ends right before the right operand starts
+                const size_t left = starts[i - 1] - 1;
+                keys[i] = keys[left] + keys[i - 1] + char(ins.op);
+                starts[i] = starts[left];
+                break;
+            }
+        }
+    }
+}
+
+SubtreeCache::Result SubtreeCache::evaluate(const Program& program, const Encoding& encoding, size_t i) {
+    const Program::Instruction& ins = program.code[i];
+
+    if(ins.arity == 0){ // leaves are never stored - variables are already a column
+        if(ins.op != CONSTANT && ins.index < size_t(points->numVars)){
+            return Result(Result(), &points->columns[ins.index]); // non-owning
+        }
+        return std::make_shared<const Operators::Column>(points->size(), ins.op == CONSTANT ? program.constants[ins.index] : VTYPE(0));
+    }
+
+    if(Result found = find(encoding.keys[i])) return found; // shared with a previously stored program
+
+    Result b = evaluate(program, encoding, i - 1),
+           a = (ins.arity == 2 ? evaluate(program, encoding, encoding.starts[i - 1] - 1) : b);
+
+    Operators::Column out(points->size());
+    if(ins.batch != nullptr) ins.batch(a->data(), b->data(), out.data(), out.size());
+    else for(size_t k=0; k < out.size(); ++k) out[k] = ins.function((*a)[k], ins.arity == 2 ? (*b)[k] : 0);
+
+    return insert(encoding.keys[i], std::move(out));
+}
+
+void SubtreeCache::splice(const Program& program, const Encoding& encoding, size_t i, Program& out, std::vector<Result>& used) {
+    const Program::Instruction& ins = program.code[i];
+
+    if(ins.arity != 0){
+        if(Result found = find(encoding.keys[i])){ // the whole subtree is known - read its results like a variable
+            ++hits;
+            out.code.push_back(Program::Instruction {Program::COLUMN, 0, ins.dst, ins.dst, ins.dst, uint32_t(out.columns.size()), nullptr, nullptr});
+            out.columns.push_back(found->data());
+            used.push_back(found); // keep the results alive while the program runs
+            return;
+        }
+        ++misses;
+        if(ins.arity == 2) splice(program, encoding, encoding.starts[i - 1] - 1, out, used);
+        splice(program, encoding, i - 1, out, used);
+    }
+    out.code.push_back(ins);
+}
+
+void SubtreeCache::store(const Program& program) {
+    if(points == nullptr || program.empty()) return;
+    evaluate(program, Encoding(program), program.code.size() - 1);
+}
+
+float SubtreeCache::score(const Program& program, const Operators::EqPoints& points, float bound, bool& rejected) {
+    if(&points != this->points || program.empty()) return program.score(points, bound, rejected); // results only belong to the dataset the cache was reset with
+
+    thread_local Program spliced;
+    std::vector<Result> used;
+    spliced.code.clear();
+    spliced.columns = program.columns;
+    spliced.constants = program.constants;
+    spliced.numSlots = program.numSlots;
+    splice(program, Encoding(program), program.code.size() - 1, spliced, used);
+
+    return spliced.score(points, bound, rejected);
+}
+
+SubtreeCache::Statistics SubtreeCache::statistics() const {
+    return Statistics {hits, misses, skipped, entries, bytes};
+}
+
+size_t SubtreeCache::takePeakMemory() {
+    return peakBytes.exchange(bytes);
+}
+
+std::string SubtreeCache::report() const {
+    Statistics stats = statistics();
+    const size_t lookups = stats.hits + stats.misses;
+    return "subtree cache: " + std::to_string(stats.hits) + " hits / " + std::to_string(lookups) + " lookups (" +
+           std::to_string(lookups ? 100 * stats.hits / lookups : 0) + "%) - " + std::to_string(stats.entries) + " results using " +
+           std::to_string(stats.bytes / 1024 / 1024) + "MB (" + std::to_string(stats.skipped) + " over budget)";
+}
@@ -5,6 +5,7 @@
 #include "visualevo.h"
 #include "csvloader.h"
 #include "syslog.h"
+#include "benchmark.h"
 
 
 #include <iostream>
@@ -27,6 +28,13 @@ int main(int argc, char** argv) {
         arguments.emplace_back( arg );
     }
 
+    int exitCode = 0;
+    std::string benchName; // test.elf --bench <name> [csv file]
+    if(arguments.size() > 2 && arguments[1] == "--bench"){
+        benchName = arguments[2];
+        arguments.erase(arguments.begin() + 1, arguments.begin() + 3); // the csv file becomes the first argument again
+    }
+
     Clock time;
 
     Parameters::Init();
@@ -76,43 +84,40 @@ int main(int argc, char** argv) {
             warning("No point cloud data loaded! Must provide point cloud data to start program");
         } else {
             // sort point cloud data via first variable (var0) as x
-            for(size_t j=0;j < data.points.size() - 1; ++j){
-                for(size_t i=j+1;i < data.points.size(); ++i){
-                    if(data.points[i][0] < data.points[j][0]){
-                        std::swap(data.points[i], data.points[j]);
-                        std::swap(data.results[i], data.results[j]);
-                    }
-                }
-            }
-
-            if(p->visual.display){
-                evoWin = new VisualEvo(580, 580, p->visual.xresolution, p->visual.yresolution);
-            }
+            data.sortByVariable(0);
 
-            if(evoWin != nullptr){
-                Clock timer;
-                do {
-                    if(timer.getSeconds() > 5){
-                        delete evoWin;
-                        evoWin = nullptr;
-                        break;
-                    }
-                } while(!evoWin->isRunning()); // wait 5 seconds for window to populate
+            if(!benchName.empty()){
+                if(!Benchmark::run(benchName, p, data)) exitCode = 1; // run a benchmark instead of the evolution - run() lists the valid names
+            } else {
+                if(p->visual.display){
+                    evoWin = new VisualEvo(580, 580, p->visual.xresolution, p->visual.yresolution);
+                }
 
                 if(evoWin != nullptr){
-                    p->visual.graph = evoWin->createGraph(p->visual.xscale, p->visual.yscale);
-                } else {
-                    warning("Failed to start VisualEvo because there might not be a display available.\nIf you wish to run without VisualEvo, please disable VisualEvo in the config file.");
+                    Clock timer;
+                    do {
+                        if(timer.getSeconds() > 5){
+                            delete evoWin;
+                            evoWin = nullptr;
+                            break;
+                        }
+                    } while(!evoWin->isRunning()); // wait 5 seconds for window to populate
+
+                    if(evoWin != nullptr){
+                        p->visual.graph = evoWin->createGraph(p->visual.xscale, p->visual.yscale);
+                    } else {
+                        warning("Failed to start VisualEvo because there might not be a display available.\nIf you wish to run without VisualEvo, please disable VisualEvo in the config file.");
+                    }
                 }
-            }
 
-            EvoAlgo evo(p, data); // auto loads parameters and data
+                EvoAlgo evo(p, data); // auto loads parameters and data
 
-            evo.run();
+                evo.run();
 
-            if(evoWin != nullptr){
-                if(!p->visual.closeOnFinish) while(evoWin->isRunning()); // wait for user to close window
-                delete evoWin;
+                if(evoWin != nullptr){
+                    if(!p->visual.closeOnFinish) while(evoWin->isRunning()); // wait for user to close window
+                    delete evoWin;
+                }
             }
         }
 
@@ -142,5 +147,5 @@ int main(int argc, char** argv) {
 
     std::this_thread::sleep_for(std::chrono::seconds(3)); // wait 3 seconds for log to flush
 
-	return 0;
+	return exitCode;
 }
@@ -0,0 +1,162 @@
+#include "threadpool.h"
+
+#include <stdexcept>
+#include <atomic>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+    thread_local size_t currentWorker = 0;
+
+    struct alignas(64) Block { // items [begin, end) of one worker packed into one word - changed by CAS, only an empty block is stored by its owner
+        std::atomic<uint64_t> range;
+    };
+
+    inline uint64_t pack(uint32_t begin, uint32_t end) { return uint64_t(end) << 32 | begin; }
+    inline uint32_t beginOf(uint64_t r) { return uint32_t(r); }
+    inline uint32_t endOf(uint64_t r) { return uint32_t(r >> 32); }
+}
+
+ThreadPool::ThreadPool(): active(0), remaining(0), epoch(0), stopping(false) {}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> l(lock);
+        done.wait(l, [this]{ return remaining == 0; }); // an exception nobody waited for is dropped
+        stopping = true;
+    }
+    for(std::condition_variable& w : wake) w.notify_one();
+    for(std::thread& t : threads) t.join();
+}
+
+void ThreadPool::dispatch(size_t workers, const Task& newTask) {
+    std::lock_guard<std::mutex> l(lock);
+    if(remaining) throw std::runtime_error("ThreadPool task dispatched while the previous task is still running");
+    while(threads.size() < workers){ // new workers join at the next epoch
+        wake.emplace_back();
+        threads.emplace_back(&ThreadPool::loop, this, threads.size(), epoch);
+    }
+
+    task = newTask;
+    active = remaining = workers;
+    ++epoch;
+    for(size_t i=0; i < workers; ++i) wake[i].notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> l(lock);
+    done.wait(l, [this]{ return remaining == 0; });
+    if(error){
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+}
+
+size_t ThreadPool::size() {
+    std::lock_guard<std::mutex> l(lock);
+    return threads.size();
+}
+
+void ThreadPool::loop(size_t index, uint64_t seen) {
+    currentWorker = index;
+    std::unique_lock<std::mutex> l(lock);
+    while(true){
+        wake[index].wait(l, [&]{ return stopping || (index < active && epoch != seen); }); // skips the tasks it is not part of
+        if(stopping) return;
+        seen = epoch;
+
+        l.unlock();
+        try {
+            task(index); // the task is not replaced before every worker is done with it
+        } catch(...) {
+            std::lock_guard<std::mutex> e(lock);
+            if(!error) error = std::current_exception();
+        }
+        l.lock();
+        if(--remaining == 0) done.notify_all();
+    }
+}
+
+size_t ThreadPool::workerIndex() {
+    return currentWorker;
+}
+
+std::string ThreadPool::Statistics::string() const {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%.3fms, %zu items on %zu workers, %.1f%% utilization, %zu steals", wall, items, workers, utilization() * 100, steals);
+    return line;
+}
+
+ThreadPool::Statistics ThreadPool::forEach(size_t workers, size_t count, const Item& item, const std::vector<double>* costs) {
+    Statistics stats {0, 0, workers, count, 0};
+    if(workers == 0 || count == 0) return stats;
+    if(count > UINT32_MAX) throw std::runtime_error("ThreadPool::forEach is limited to " + std::to_string(UINT32_MAX) + " items");
+
+    std::vector<uint32_t> order; // item of every position - only with costs
+    if(costs != nullptr){
+        std::vector<uint32_t> sorted(count);
+        for(size_t i=0; i < count; ++i) sorted[i] = uint32_t(i);
+        std::stable_sort(sorted.begin(), sorted.end(), [costs](uint32_t l, uint32_t r){ return (*costs)[l] > (*costs)[r]; });
+        order.resize(count);
+        size_t at = 0;
+        for(size_t w=0; w < workers; ++w){ // deal round robin - block w holds sorted[w], sorted[w + workers], ...
+            for(size_t k=w; k < count; k += workers) order[at++] = sorted[k];
+        }
+    }
+
+    std::unique_ptr<Block[]> blocks(new Block[workers]);
+    for(size_t w=0, begin=0; w < workers; ++w){ // the same cut as the dealing above - block sizes differ by at most one
+        const size_t size = (count - w + workers - 1) / workers;
+        blocks[w].range = pack(uint32_t(begin), uint32_t(begin + size));
+        begin += size;
+    }
+    const uint32_t chunk = uint32_t(std::clamp<size_t>(count / (workers * 16), 1, 64)); // small enough to balance, large enough to keep the CAS traffic down
+    std::atomic<size_t> steals(0);
+    std::vector<double> busy(workers, 0);
+
+    const auto start = std::chrono::steady_clock::now();
+    run(workers, [&](size_t w){
+        std::atomic<uint64_t>& own = blocks[w].range;
+        const auto begun = std::chrono::steady_clock::now();
+        while(true){
+            uint64_t r = own.load();
+            const uint32_t b = beginOf(r), e = endOf(r);
+            if(b < e){ // take a chunk from the front of my block
+                const uint32_t next = std::min(b + chunk, e);
+                if(!own.compare_exchange_weak(r, pack(next, e))) continue;
+                for(uint32_t p=b; p < next; ++p) item(costs != nullptr ? order[p] : p);
+                continue;
+            }
+
+            bool stolen = false; // my block is empty - steal the back half of the largest block of the others
+            while(!stolen){
+                size_t victim = workers, largest = 0;
+                for(size_t v=0; v < workers; ++v){
+                    const uint64_t vr = blocks[v].range.load(std::memory_order_relaxed);
+                    const size_t left = endOf(vr) > beginOf(vr) ? endOf(vr) - beginOf(vr) : 0;
+                    if(v != w && left > largest){ largest = left; victim = v; }
+                }
+                if(victim == workers) break; // nothing left anywhere
+
+                uint64_t vr = blocks[victim].range.load();
+                const uint32_t vb = beginOf(vr), ve = endOf(vr);
+                if(vb >= ve) continue;
+                const uint32_t mid = vb + (ve - vb) / 2; // a single item is taken whole
+                if(blocks[victim].range.compare_exchange_strong(vr, pack(vb, mid))){
+                    own.store(pack(mid, ve)); // my block is empty - nobody else writes it
+                    ++steals;
+                    stolen = true;
+                }
+            }
+            if(!stolen) break;
+        }
+        busy[w] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begun).count();
+    });
+    stats.wall = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    for(double b : busy) stats.busy += b;
+    stats.steals = steals;
+    return stats;
+}
@@ -126,6 +126,10 @@ VisualEvo::Graph::Graph(VisualEvo* evo, uint32_t w, uint32_t h, float xs, float
 
 	}
 
+size_t VisualEvo::Graph::memoryUsage() const {
+	return sizeof(Graph) + (surface == nullptr ? 0 : size_t(surface->width) * size_t(surface->height) * sizeof(olc::Pixel));
+}
+
 VisualEvo::Graph::~Graph() {
 	delete surface;
 }
@@ -148,9 +152,9 @@ void VisualEvo::Graph::drawAdd(const Operators::EqPoints &points, uint32_t varIn
 	}
 
 	std::vector<olc::vf2d> dataPoints;
-	for(size_t i=0; i < points.points.size(); ++i){
+	for(size_t i=0; i < points.size(); ++i){
 		dataPoints.push_back({
-			float(points.points[i][varIndex]), // x
+			float(points.columns[varIndex][i]), // x
 			float(points.results[i]) 	// y
 		});
 	}